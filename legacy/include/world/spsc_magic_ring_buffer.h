@@ -0,0 +1,182 @@
+/*
+ * \brief  Single-producer/single-consumer magic ring buffer
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _INCLUDE__WORLD__SPSC_MAGIC_RING_BUFFER_H_
+#define _INCLUDE__WORLD__SPSC_MAGIC_RING_BUFFER_H_
+
+/* Genode includes */
+#include <base/attached_dataspace.h>
+#include <rm_session/connection.h>
+#include <region_map/client.h>
+#include <dataspace/client.h>
+
+namespace Genode {
+	template <typename TYPE>
+	class Spsc_magic_ring_buffer;
+}
+
+
+/**
+ * A ring buffer that uses a single dataspace mapped twice in consecutive
+ * regions, safe for one producer and one consumer on different threads
+ *
+ * Like 'Magic_ring_buffer', any operation up to the size of the buffer may
+ * be done in a single pass. The read and write positions are free-running
+ * counters that are masked with the power-of-two capacity, so all items of
+ * the ring are usable. The producer publishes written items with release
+ * semantics and the consumer observes them with acquire semantics, and
+ * vice versa for drained items.
+ *
+ * Only the producer may call 'write_avail', 'write_addr', and 'fill'.
+ * Only the consumer may call 'read_avail', 'read_addr', and 'drain'.
+ */
+template <typename TYPE>
+class Genode::Spsc_magic_ring_buffer
+{
+	private:
+
+		Spsc_magic_ring_buffer(Spsc_magic_ring_buffer const &);
+		Spsc_magic_ring_buffer &operator = (Spsc_magic_ring_buffer const &);
+
+		Genode::Env &_env;
+
+		static size_t _pow2_size(size_t num_bytes)
+		{
+			/* the smallest dataspace is one page */
+			size_t size = 1UL << 12;
+			while (size < num_bytes)
+				size <<= 1;
+			return size;
+		}
+
+		Ram_dataspace_capability _buffer_ds;
+
+		size_t const _ds_size  = Dataspace_client(_buffer_ds).size();
+		size_t const _capacity = _ds_size / sizeof(TYPE);
+		size_t const _mask     = _capacity - 1;
+
+		Rm_connection _rm_connection { _env };
+
+		/* create region map (reserve address space) */
+		Region_map_client _rm { _rm_connection.create(_ds_size*2) };
+
+		/* attach map to global region map */
+		Attached_dataspace _managed_ds { _env.rm(), _rm.dataspace() };
+		TYPE *_buffer = _managed_ds.local_addr<TYPE>();
+
+		/*
+		 * Positions are kept on separate cache lines to avoid false
+		 * sharing between the producer and consumer
+		 */
+		alignas(64) size_t _wpos = 0;
+		alignas(64) size_t _rpos = 0;
+
+		static size_t _load_acquire(size_t const &pos) {
+			return __atomic_load_n(&pos, __ATOMIC_ACQUIRE); }
+
+		static size_t _load_relaxed(size_t const &pos) {
+			return __atomic_load_n(&pos, __ATOMIC_RELAXED); }
+
+		static void _store_release(size_t &pos, size_t value) {
+			__atomic_store_n(&pos, value, __ATOMIC_RELEASE); }
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param TYPE  Ring item type, size of type must be a
+		 *              power of two and less than the page size
+		 *
+		 * \param env       Env for dataspace allocation and mapping
+		 * \param num_bytes Size of ring in bytes, rounded up to the
+		 *                  next power of two of at least the page size
+		 *
+		 * \throw Region_map::Region_conflict
+		 * \throw Out_of_ram
+		 * \throw Out_of_caps
+		 */
+		Spsc_magic_ring_buffer(Genode::Env &env, size_t num_bytes)
+		: _env(env), _buffer_ds(_env.ram().alloc(_pow2_size(num_bytes)))
+		{
+			static_assert((sizeof(TYPE) & (sizeof(TYPE) - 1)) == 0,
+			              "size of ring item type must be a power of two");
+
+			auto attach_at = [&] (addr_t const offset)
+			{
+				auto result = _rm.attach(_buffer_ds, {
+					.size       = _ds_size,  .offset    = offset,
+					.use_at     = { },       .at        = { },
+					.executable = { },       .writeable = true });
+				if (result.failed()) {
+					error("Spsc_magic_ring_buffer out of resources");
+					throw Exception();
+				}
+			};
+
+			/* attach buffer dataspace twice into reserved region */
+			attach_at(0);
+			attach_at(_ds_size);
+		}
+
+		~Spsc_magic_ring_buffer()
+		{
+			/* detach dataspace from reserved region */
+			_rm.detach(_ds_size);
+			_rm.detach(0);
+
+			/* free buffer */
+			_env.ram().free(_buffer_ds);
+		}
+
+		/**
+		 * Ring capacity of TYPE items
+		 */
+		size_t capacity() const { return _capacity; }
+
+		/**
+		 * Number of items that may be written to ring
+		 */
+		size_t write_avail() const {
+			return _capacity - (_load_relaxed(_wpos) - _load_acquire(_rpos)); }
+
+		/**
+		 * Number of items that may be read from ring
+		 */
+		size_t read_avail() const {
+			return _load_acquire(_wpos) - _load_relaxed(_rpos); }
+
+		/**
+		 * Pointer to ring write address
+		 */
+		TYPE *write_addr() const { return &_buffer[_load_relaxed(_wpos) & _mask]; }
+
+		/**
+		 * Pointer to ring read address
+		 */
+		TYPE *read_addr() const { return &_buffer[_load_relaxed(_rpos) & _mask]; }
+
+		/**
+		 * Advance the ring write pointer, publishing the written items
+		 */
+		void fill(size_t items) {
+			_store_release(_wpos, _load_relaxed(_wpos) + items); }
+
+		/**
+		 * Advance the ring read pointer, releasing the drained items
+		 */
+		void drain(size_t items) {
+			_store_release(_rpos, _load_relaxed(_rpos) + items); }
+};
+
+#endif /* _INCLUDE__WORLD__SPSC_MAGIC_RING_BUFFER_H_ */
@@ -0,0 +1,16 @@
+SRC_DIR = src/app/codec_audio_sink
+include $(GENODE_DIR)/repos/base/recipes/src/content.inc
+
+MIRROR_FROM_REP_DIR := include/world/spsc_magic_ring_buffer.h
+
+RAW_AUDIO_SINK_FILES := src/app/raw_audio_sink/deinterleave.h \
+                        src/app/raw_audio_sink/convert.h
+
+content: $(RAW_AUDIO_SINK_FILES) $(MIRROR_FROM_REP_DIR)
+
+$(RAW_AUDIO_SINK_FILES):
+	mkdir -p $(dir $@)
+	cp $(REP_DIR)/$@ $@
+
+$(MIRROR_FROM_REP_DIR):
+	$(mirror_from_rep_dir)
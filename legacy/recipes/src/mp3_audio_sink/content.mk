@@ -1,8 +1,13 @@
 SRC_DIR = src/app/mp3_audio_sink
 include $(GENODE_DIR)/repos/base/recipes/src/content.inc
 
-content: src/app/raw_audio_sink/magic_ring_buffer.h
+MIRROR_FROM_REP_DIR := include/world/spsc_magic_ring_buffer.h
 
-src/app/raw_audio_sink/magic_ring_buffer.h:
+content: src/app/raw_audio_sink/deinterleave.h $(MIRROR_FROM_REP_DIR)
+
+src/app/raw_audio_sink/deinterleave.h:
 	mkdir -p $(dir $@)
-	cp $(REP_DIR)/src/app/raw_audio_sink/magic_ring_buffer.h $@
+	cp $(REP_DIR)/src/app/raw_audio_sink/deinterleave.h $@
+
+$(MIRROR_FROM_REP_DIR):
+	$(mirror_from_rep_dir)
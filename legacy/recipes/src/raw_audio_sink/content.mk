@@ -1,2 +1,9 @@
 SRC_DIR = src/app/raw_audio_sink
 include $(GENODE_DIR)/repos/base/recipes/src/content.inc
+
+MIRROR_FROM_REP_DIR := include/world/spsc_magic_ring_buffer.h
+
+content: $(MIRROR_FROM_REP_DIR)
+
+$(MIRROR_FROM_REP_DIR):
+	$(mirror_from_rep_dir)
@@ -0,0 +1,9 @@
+MIRROR_FROM_REP_DIR := src/lib/vfs/block_cache lib/mk/vfs_block_cache.mk
+
+content: $(MIRROR_FROM_REP_DIR) LICENSE
+
+$(MIRROR_FROM_REP_DIR):
+	$(mirror_from_rep_dir)
+
+LICENSE:
+	cp $(GENODE_DIR)/LICENSE $@
@@ -0,0 +1,113 @@
+/*
+ * \brief  Resumable shredding state
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _BLOCK_SHRED__CHECKPOINT_H_
+#define _BLOCK_SHRED__CHECKPOINT_H_
+
+/* Genode includes */
+#include <block_session/block_session.h>
+#include <base/attached_rom_dataspace.h>
+#include <os/reporter.h>
+
+/* local includes */
+#include <noise.h>
+
+namespace Blk_shred { struct Checkpoint; }
+
+
+/**
+ * Position of a shredding run
+ *
+ * All blocks of the passes preceding 'pass' and all blocks of 'pass'
+ * below 'block' are complete. The noise seed is stored along with the
+ * position so that a resumed run continues the same keystream and a later
+ * verification pass can check data written before the restart.
+ */
+struct Blk_shred::Checkpoint
+{
+	enum { SEED_WORDS = 10 };
+
+	typedef String<SEED_WORDS*8 + 1> Seed_string;
+
+	Block::sector_t block_count = 0;
+	size_t          block_size  = 0;
+
+	unsigned        pass  = 0;
+	Block::sector_t block = 0;
+
+	Noise::Seed seed { };
+
+	static uint32_t *_seed_words(Noise::Seed &seed) {
+		return (uint32_t *)&seed; }
+
+	static_assert(sizeof(Noise::Seed) == SEED_WORDS*sizeof(uint32_t),
+	              "unexpected seed layout");
+
+	Seed_string _seed_string() const
+	{
+		static char const digits[] = "0123456789abcdef";
+
+		char buf[SEED_WORDS*8 + 1] { };
+		uint32_t const *words = (uint32_t const *)&seed;
+		for (unsigned w = 0; w < SEED_WORDS; ++w)
+			for (unsigned i = 0; i < 8; ++i)
+				buf[w*8 + i] = digits[(words[w] >> (28 - i*4)) & 0xf];
+
+		return Seed_string(Cstring(buf));
+	}
+
+	static bool _parse_seed(Seed_string const &s, Noise::Seed &seed)
+	{
+		if (s.length() != SEED_WORDS*8 + 1)
+			return false;
+
+		uint32_t *words = _seed_words(seed);
+		for (unsigned w = 0; w < SEED_WORDS; ++w) {
+			words[w] = 0;
+			for (unsigned i = 0; i < 8; ++i) {
+				char const c = s.string()[w*8 + i];
+				if (!is_digit(c, true))
+					return false;
+				words[w] = (words[w] << 4) | digit(c, true);
+			}
+		}
+		return true;
+	}
+
+	void generate(Generator &g) const
+	{
+		g.attribute("block_count", block_count);
+		g.attribute("block_size",  block_size);
+		g.attribute("pass",        pass);
+		g.attribute("block",       block);
+		g.attribute("seed",        _seed_string());
+	}
+
+	/**
+	 * Import a checkpoint report
+	 *
+	 * \return false if the node does not describe a valid checkpoint
+	 */
+	bool import(Node const &node)
+	{
+		block_count = node.attribute_value("block_count", Block::sector_t(0));
+		block_size  = node.attribute_value("block_size",  size_t(0));
+		pass        = node.attribute_value("pass",        0U);
+		block       = node.attribute_value("block",       Block::sector_t(0));
+
+		return block_count && block_size
+		    && _parse_seed(node.attribute_value("seed", Seed_string()), seed);
+	}
+};
+
+#endif
@@ -11,14 +11,11 @@
  * under the terms of the GNU Affero General Public License version 3.
  */
 
-/**
- * TODO:
- * - Progress report
- */
-
 /* Genode includes */
 #include <block_session/connection.h>
 #include <timer_session/connection.h>
+#include <base/attached_rom_dataspace.h>
+#include <os/reporter.h>
 #include <base/heap.h>
 #include <base/component.h>
 #include <base/sleep.h>
@@ -32,22 +29,91 @@
 /* PCG includes */
 #include <pcg_variants.h>
 
+/* local includes */
+#include <noise.h>
+#include <checkpoint.h>
+
 
 namespace Blk_shred {
 	using namespace Genode;
 	using namespace Block;
+	struct Pass;
 	struct Main;
 
 	enum {
 		/* XXX: part_blk has a fixed backend buffer that limits our packet size */
-		PKT_SIZE = 1 << 20,
-		PKT_BUF_SIZE = PKT_SIZE*2 + (32<<10)
+		DEFAULT_PKT_SIZE    = 1 << 20,
+		DEFAULT_QUEUE_DEPTH = 8,
+		MAX_QUEUE_DEPTH     = 64,
+		MAX_PASSES          = 16,
+		PKT_BUF_SLACK       = 32 << 10,
+		DEFAULT_REPORT_INTERVAL_MS = 5000,
+
+		/* progress between two reads of the timer */
+		REPORT_CHECK_BYTES = 16 << 20,
 	};
-
-	uint64_t pcg_init[2] PCG32_INITIALIZER;
 }
 
 
+struct Blk_shred::Pass
+{
+	enum Type { ZERO, RANDOM, VERIFY, SPOT, INVALID };
+
+	typedef String<16> Name;
+
+	Type type = INVALID;
+
+	/* verify one in 'sample_interval' blocks */
+	size_t sample_interval = 1;
+
+	/* read back each packet of a writing pass right after it is written */
+	bool verify_inline = false;
+
+	/**
+	 * Constructor
+	 *
+	 * \param block_size  block size of the device, a spot check samples
+	 *                    one block per MiB by default
+	 */
+	Pass(Node const &node, size_t block_size)
+	:
+		type(type_of(node.attribute_value("type", Name()))),
+		sample_interval(max((size_t)1,
+			node.attribute_value("sample_interval",
+			                     type == SPOT ? (1<<20)/block_size : 1))),
+		verify_inline(writes(type) && node.attribute_value("verify", false))
+	{ }
+
+	Pass(Type type, size_t sample_interval)
+	: type(type), sample_interval(sample_interval) { }
+
+	Pass() { }
+
+	static Type type_of(Name const &name)
+	{
+		if (name == "zero")   return ZERO;
+		if (name == "random") return RANDOM;
+		if (name == "verify") return VERIFY;
+		if (name == "spot")   return SPOT;
+		return INVALID;
+	}
+
+	static char const *name(Type type)
+	{
+		switch (type) {
+		case ZERO:    return "zero";
+		case RANDOM:  return "random";
+		case VERIFY:  return "verify";
+		case SPOT:    return "spot";
+		case INVALID: break;
+		}
+		return "invalid";
+	}
+
+	static bool writes(Type type) { return type == ZERO || type == RANDOM; }
+};
+
+
 struct Blk_shred::Main
 {
 	Main(Main const &);
@@ -59,17 +125,58 @@ struct Blk_shred::Main
 
 	Heap heap { env.ram(), env.rm() };
 
+	Attached_rom_dataspace config_rom { env, "config" };
+
+	Node const config = config_rom.node();
+
+	/*
+	 * Number of packets kept in flight, one additional packet
+	 * is filled with noise while the device processes the queue
+	 */
+	unsigned const queue_depth = max(1U, min((unsigned)MAX_QUEUE_DEPTH,
+		config.attribute_value("queue_depth", (unsigned)DEFAULT_QUEUE_DEPTH)));
+
+	size_t const packet_size =
+		config.attribute_value("packet_size", Number_of_bytes(DEFAULT_PKT_SIZE));
+
+	uint64_t const report_interval_ms =
+		config.attribute_value("report_interval_ms",
+		                       (uint64_t)DEFAULT_REPORT_INTERVAL_MS);
+
 	Allocator_avl packet_alloc { &heap };
 
 	Block::Connection<> blk {
-		env, &packet_alloc, PKT_BUF_SIZE };
+		env, &packet_alloc, packet_size*(queue_depth+1) + PKT_BUF_SLACK };
 
 	Block::Session::Tx::Source &pkt_source = *blk.tx();
 
 	Block::Session::Info const info { blk.info() };
 
 	rand_data *jent { nullptr };
-	pcg32_random_t pcg PCG32_INITIALIZER;
+
+	Noise::Seed seed { };
+	Noise       noise { seed };
+
+	Pass     passes[MAX_PASSES] { };
+	unsigned num_passes = 0;
+
+	/* pass and block to start from, non-zero if resuming */
+	unsigned        current_pass = 0;
+	Block::sector_t resume_block = 0;
+
+	/* pattern written by the last writing pass */
+	Pass::Type written = Pass::INVALID;
+
+	/* a weak RNG to select the blocks to verify */
+	pcg32_random_t sample_gen { };
+
+	Constructible<Expanding_reporter> progress_reporter { };
+	Constructible<Expanding_reporter> checkpoint_reporter { };
+
+	uint64_t pass_start_ms    = 0;
+	uint64_t last_report_ms   = 0;
+	uint64_t last_check_block = 0;
+	uint64_t pass_start_block = 0;
 
 	template <typename... ARGS>
 	void die(ARGS &&... args)
@@ -84,26 +191,79 @@ struct Blk_shred::Main
 
 	void seed_noise()
 	{
-		/* read entropy into initialization variables */
+		/* read entropy into the key and nonce */
 
 		{
 			/* XOR in jitter entropy */
-			uint64_t buf[2] { 0 };
+			Noise::Seed buf { };
 			jent_read_entropy(jent, (char*)&buf, sizeof(buf));
-			pcg_init[0] ^= buf[0];
-			pcg_init[1] ^= buf[1];
+			for (unsigned i = 0; i < 8; ++i)
+				seed.key[i] ^= buf.key[i];
+			for (unsigned i = 0; i < 2; ++i)
+				seed.nonce[i] ^= buf.nonce[i];
+			buf.wipe();
 		}
 
 		if (Genode::Rdrand::supported()) {
 			/* XOR in RDRAND */
-			pcg_init[0] ^= Genode::Rdrand::random64();
-			pcg_init[1] ^= Genode::Rdrand::random64();
+			for (unsigned i = 0; i < 8; i += 2) {
+				uint64_t const r = Genode::Rdrand::random64();
+				seed.key[i]   ^= uint32_t(r);
+				seed.key[i+1] ^= uint32_t(r >> 32);
+			}
+		}
+
+		noise.rekey(seed);
+	}
+
+	void import_passes()
+	{
+		config.for_each_sub_node("pass", [&] (Node const &node) {
+			Pass const pass(node, info.block_size);
+
+			if (pass.type == Pass::INVALID)
+				die("invalid pass type \"",
+				    node.attribute_value("type", Pass::Name()), "\"");
+			if (num_passes == MAX_PASSES)
+				die("more than ", (unsigned)MAX_PASSES, " passes configured");
+
+			passes[num_passes++] = pass;
+		});
+
+		/* shred with noise and spot-check the result by default */
+		if (!num_passes) {
+			passes[num_passes++] = Pass(Pass::RANDOM, 1);
+			passes[num_passes++] = Pass(Pass::SPOT, (1<<20)/info.block_size);
+		}
+	}
+
+	void import_checkpoint()
+	{
+		Attached_rom_dataspace rom { env, "checkpoint" };
+
+		Checkpoint checkpoint { };
+		if (!checkpoint.import(rom.node())) {
+			log("no checkpoint found, starting from the beginning");
+			return;
 		}
 
-		/* low bit must be set */
-		pcg_init[1] |= 1;
+		if (checkpoint.block_count != info.block_count
+		 || checkpoint.block_size  != info.block_size) {
+			warning("checkpoint does not match the device geometry, ignoring it");
+			return;
+		}
+
+		current_pass = checkpoint.pass;
+		resume_block = checkpoint.block;
+		seed         = checkpoint.seed;
+		noise.rekey(seed);
+		checkpoint.seed.wipe();
 
-		pcg32_srandom_r(&pcg, pcg_init[0], pcg_init[1]);
+		for (unsigned p = 0; p < min(current_pass, num_passes); ++p)
+			if (Pass::writes(passes[p].type))
+				written = passes[p].type;
+
+		log("resuming at pass ", current_pass, " block ", resume_block);
 	}
 
 	Main(Genode::Env &env) : env(env)
@@ -122,8 +282,34 @@ struct Blk_shred::Main
 
 		seed_noise();
 
+		{
+			uint64_t buf[2] { 0 };
+			jent_read_entropy(jent, (char*)&buf, sizeof(buf));
+			pcg32_srandom_r(&sample_gen, buf[0], buf[1]);
+		}
+
 		if (!info.writeable)
 			die("block device not writeable!");
+
+		if (info.block_size % Noise::CHUNK_SIZE)
+			die("block size of ", info.block_size, " is not a multiple of ",
+			    (unsigned)Noise::CHUNK_SIZE);
+
+		if (packet_size < info.block_size)
+			die("packet size of ", Number_of_bytes(packet_size),
+			    " is less than block size of ", info.block_size);
+
+		import_passes();
+
+		config.with_optional_sub_node("report", [&] (Node const &node) {
+			if (node.attribute_value("progress", false))
+				progress_reporter.construct(env, "progress", "progress");
+			if (node.attribute_value("checkpoint", false))
+				checkpoint_reporter.construct(env, "checkpoint", "checkpoint");
+		});
+
+		if (config.attribute_value("resume", false))
+			import_checkpoint();
 	}
 
 	~Main()
@@ -131,147 +317,385 @@ struct Blk_shred::Main
 		/* wipe noise state */
 		seed_noise();
 
+		seed.wipe();
+		noise.wipe();
+
 		jent_entropy_collector_free(jent);
 	}
 
-	void submit_noise(Block::Packet_descriptor const &pkt)
+	/**
+	 * Report progress and store a checkpoint
+	 *
+	 * \param done   all blocks of the current pass below are complete
+	 * \param force  report regardless of the report interval
+	 */
+	void report(Block::sector_t done, bool force = false)
 	{
-		uint32_t *buffer = (uint32_t*)pkt_source.packet_content(pkt);
-		for (size_t i = 0; i < ((pkt.block_count()*info.block_size) / sizeof(uint32_t)); ++i)
-			buffer[i] = pcg32_random_r(&pcg);
-		pkt_source.submit_packet(pkt);
+		/* spare the timer RPC until enough progress was made */
+		if (!force && done >= last_check_block
+		 && (done - last_check_block)*info.block_size < REPORT_CHECK_BYTES)
+			return;
+		last_check_block = done;
+
+		uint64_t const now_ms = timer.elapsed_ms();
+		if (!force && now_ms - last_report_ms < report_interval_ms)
+			return;
+		last_report_ms = now_ms;
+
+		if (checkpoint_reporter.constructed()) {
+			Checkpoint checkpoint { };
+			checkpoint.block_count = info.block_count;
+			checkpoint.block_size  = info.block_size;
+			checkpoint.pass        = current_pass;
+			checkpoint.block       = done;
+			checkpoint.seed        = seed;
+
+			checkpoint_reporter->generate([&] (Generator &g) {
+				checkpoint.generate(g); });
+			checkpoint.seed.wipe();
+		}
+
+		if (!progress_reporter.constructed())
+			return;
+
+		uint64_t const total = info.block_count*info.block_size;
+		uint64_t const bytes = done*info.block_size;
+
+		/* rate of this run, excluding blocks done before a restart */
+		uint64_t const ms    = max(now_ms - pass_start_ms, (uint64_t)1);
+		uint64_t const rate  = ((done - pass_start_block)*info.block_size*1000) / ms;
+		uint64_t const eta_s = rate ? (total - bytes) / rate : 0;
+
+		progress_reporter->generate([&] (Generator &g) {
+			g.attribute("pass",      current_pass);
+			g.attribute("passes",    num_passes);
+			g.attribute("type",      Pass::name(current_pass < num_passes
+			                                    ? passes[current_pass].type
+			                                    : Pass::INVALID));
+			g.attribute("bytes",     bytes);
+			g.attribute("total",     total);
+			g.attribute("mib_per_s", rate >> 20);
+			g.attribute("eta_s",     eta_s);
+			g.attribute("complete",  current_pass >= num_passes);
+		});
 	}
 
-	void shred()
+	/**
+	 * Number of blocks of the packet at 'blk_offset'
+	 *
+	 * The first packet aligns those that follow with the end of
+	 * the device.
+	 */
+	size_t packet_count(Block::sector_t blk_offset, size_t blk_per_pkt)
 	{
-		float const mbytes = (float(info.block_count) * float(info.block_size)) / (1<<20);
-		log("shredding ", mbytes/(1<<10), " GiB...");
-		auto start_ms = timer.elapsed_ms();
+		size_t first_count = info.block_count % blk_per_pkt;
+		if (first_count == 0)
+			first_count = blk_per_pkt;
+
+		if (blk_offset < first_count)
+			return first_count - blk_offset;
+
+		return min((Block::sector_t)blk_per_pkt, info.block_count - blk_offset);
+	}
 
-		size_t const blk_per_pkt = PKT_SIZE / info.block_size;
-		size_t const bytes_per_pkt =  blk_per_pkt * info.block_size;
+	/**
+	 * Stream packets over the device range starting at 'start'
+	 *
+	 * The range is split into regions of 'region_blocks', packet-sized
+	 * by default, a region must not be smaller than a packet unless it
+	 * is read only partially by 'prepare'. 'prepare' is called
+	 * with a packet-buffer region and the device region and returns the
+	 * packet to submit. 'complete' is called with each acknowledged
+	 * packet and may return a follow-up packet for the same buffer
+	 * region. Up to 'queue_depth' packets are in flight while the next
+	 * packet is prepared.
+	 */
+	template <typename PREPARE, typename COMPLETE>
+	void process(Block::sector_t start,
+	             PREPARE const &prepare, COMPLETE const &complete,
+	             size_t region_blocks = 0)
+	{
+		size_t const blk_per_pkt   = packet_size / info.block_size;
+		size_t const bytes_per_pkt = blk_per_pkt * info.block_size;
+		size_t const blk_per_rgn   = max(region_blocks, blk_per_pkt);
 
 		/*
-		 * send two packets in succession, the first write
-		 * aligns those that follow with end of the device
+		 * Packet-buffer regions, one more than the queue depth so that
+		 * the next packet can be prepared while the queue is saturated
 		 */
-		Block::sector_t blk_offset = info.block_count % blk_per_pkt;
-		if (blk_offset == 0)
-			blk_offset = blk_per_pkt;
-
+		struct Slot
 		{
-			Block::Packet_descriptor pkt(
-				pkt_source.alloc_packet(bytes_per_pkt),
-				Block::Packet_descriptor::WRITE,
-				0, blk_offset);
-			submit_noise(pkt);
-		}
+			Block::Packet_descriptor pkt { };
+			bool busy = false;
+		};
+
+		Slot slots[MAX_QUEUE_DEPTH+1];
+		unsigned const num_slots = queue_depth + 1;
+		for (unsigned i = 0; i < num_slots; ++i)
+			slots[i].pkt = pkt_source.alloc_packet(bytes_per_pkt);
+
+		Block::sector_t blk_offset = start;
+		Slot           *staged     = nullptr;
+		unsigned        in_flight  = 0;
+
+		auto free_slot = [&] () -> Slot * {
+			for (unsigned i = 0; i < num_slots; ++i)
+				if (!slots[i].busy) return &slots[i];
+			return nullptr;
+		};
+
+		/* blocks below the first busy packet are complete */
+		auto done = [&] () {
+			Block::sector_t result = blk_offset;
+			for (unsigned i = 0; i < num_slots; ++i)
+				if (slots[i].busy)
+					result = min(result, slots[i].pkt.block_number());
+			return result;
+		};
+
+		while (blk_offset < info.block_count || staged || in_flight) {
+
+			/* prepare the next packet while the device is busy */
+			if (!staged && blk_offset < info.block_count) {
+				if (Slot *slot = free_slot()) {
+					size_t const count = packet_count(blk_offset, blk_per_rgn);
+					slot->pkt  = prepare(slot->pkt, blk_offset, count);
+					slot->busy = true;
+					staged      = slot;
+					blk_offset += count;
+				}
+			}
+
+			if (staged && in_flight < queue_depth) {
+				pkt_source.submit_packet(staged->pkt);
+				staged = nullptr;
+				++in_flight;
+				continue;
+			}
+
+			/* the queue is saturated or there is nothing left to prepare */
+			Block::Packet_descriptor const ack = pkt_source.get_acked_packet();
+			--in_flight;
+
+			for (unsigned i = 0; i < num_slots; ++i) {
+				Slot &slot = slots[i];
+				if (!slot.busy || slot.pkt.offset() != ack.offset())
+					continue;
+
+				Block::Packet_descriptor next { };
+				if (complete(ack, next)) {
+					slot.pkt = next;
+					pkt_source.submit_packet(next);
+					++in_flight;
+				} else {
+					slot.pkt  = ack;
+					slot.busy = false;
+				}
+				break;
+			}
 
-		{
-			Block::Packet_descriptor pkt(
-				pkt_source.alloc_packet(bytes_per_pkt),
-				Block::Packet_descriptor::WRITE,
-				blk_offset, blk_per_pkt);
-			submit_noise(pkt);
-			blk_offset += blk_per_pkt;
+			report(done());
 		}
 
-		while (true) {
-			Block::Packet_descriptor const ack = pkt_source.get_acked_packet();
-			if (!ack.succeeded())
-				error("ack indicates failure ", ack.block_number(),"/",info.block_count);
+		for (unsigned i = 0; i < num_slots; ++i)
+			pkt_source.release_packet(slots[i].pkt);
+	}
 
-			pkt_source.release_packet(ack);
+	/*
+	 * Blocks of the current pass that are not yet accounted for by a
+	 * sample, negative if more blocks were read than were due
+	 */
+	int64_t sample_credit = 0;
 
-			if (blk_offset >= info.block_count) break;
+	/**
+	 * Read packet for the sampled blocks of a device region
+	 *
+	 * A contiguous window of one in 'sample_interval' blocks is read
+	 * at a random position within the region. The remainder of a region
+	 * is carried over to the next one, so the density does not depend
+	 * on the size of the regions.
+	 *
+	 * \param force  read at least one block, otherwise the packet is
+	 *               empty if no block of the region is due
+	 */
+	Block::Packet_descriptor sample(Block::Packet_descriptor const &region,
+	                                Block::sector_t start, size_t count,
+	                                size_t sample_interval, bool force)
+	{
+		sample_credit += count;
 
-			/* reuse packet buffer region */
-			Block::Packet_descriptor const pkt(
-				ack, Block::Packet_descriptor::WRITE,
-				blk_offset, blk_per_pkt);
-			submit_noise(pkt);
-			blk_offset += blk_per_pkt;
-		}
+		size_t n = sample_credit > 0
+		         ? min(count, size_t(sample_credit) / sample_interval) : 0;
+		if (force && n == 0)
+			n = 1;
 
-		Block::Packet_descriptor const ack = pkt_source.get_acked_packet();
-		if (!ack.succeeded())
-			error("ack indicates failure ", ack.block_number(),"/",info.block_count);
+		sample_credit -= int64_t(n*sample_interval);
 
-		float seconds = (timer.elapsed_ms() - start_ms) / 1000;
-		log("shred complete, ", mbytes / seconds, " MiB/s");
+		Block::sector_t const first = (n < count)
+			? start + pcg32_boundedrand_r(&sample_gen, uint32_t(count - n + 1))
+			: start;
+
+		return Block::Packet_descriptor(region, Block::Packet_descriptor::READ,
+		                                first, n);
+	}
+
+	void fill(Block::Packet_descriptor const &pkt, Pass::Type type)
+	{
+		void * const content = pkt_source.packet_content(pkt);
+		size_t const size    = pkt.block_count()*info.block_size;
+
+		if (type == Pass::ZERO) {
+			memset(content, 0, size);
+			return;
+		}
+
+		noise.seek(pkt.block_number()*info.block_size);
+		noise.generate(content, size);
 	}
 
 	/**
-	 * Verify a block, PCG must first be seeked into position
+	 * Check blocks against the pattern of the last writing pass
 	 */
-	bool verify_block(Block::sector_t sector)
+	void check(Block::sector_t sector, size_t count, void const *content)
 	{
-		Block::Packet_descriptor pkt(
-			pkt_source.alloc_packet(info.block_size),
-			Block::Packet_descriptor::READ, sector, 1);
+		for (size_t i = 0; i < count; ++i) {
+
+			char const * const block =
+				(char const *)content + i*info.block_size;
+			bool valid = true;
+
+			if (written == Pass::ZERO) {
+				uint64_t const *words = (uint64_t const *)block;
+				for (size_t w = 0; w < info.block_size/sizeof(uint64_t); ++w)
+					if (words[w]) { valid = false; break; }
+			} else {
+				noise.seek((sector + i)*info.block_size);
+				valid = noise.verify(block, info.block_size);
+			}
+
+			if (!valid)
+				die("sector ", sector + i, " is invalid");
+		}
+	}
 
-		pkt_source.submit_packet(pkt);
-		pkt = pkt_source.get_acked_packet();
-		pkt_source.release_packet(pkt);
+	/* number of blocks read back during the current pass */
+	Block::sector_t verified = 0;
 
-		if (!pkt.succeeded())
-			die("error while reading back sector ", sector);
+	void check_read(Block::Packet_descriptor const &ack)
+	{
+		if (!ack.succeeded())
+			die("error while reading back sector ", ack.block_number());
 
-		uint32_t *buffer = (uint32_t*)pkt_source.packet_content(pkt);
-		for (size_t i = 0; i < (info.block_size / sizeof(uint32_t)); ++i) {
-			if (buffer[i] != pcg32_random_r(&pcg))
-				die("sector ", sector, " is invalid");
-		}
-		return true;
+		check(ack.block_number(), ack.block_count(),
+		      pkt_source.packet_content(ack));
+		verified += ack.block_count();
 	}
 
-	/**
-	 * Verify random blocks
-	 */
-	void verify()
+	void write_pass(Pass const &pass, Block::sector_t start)
 	{
-		/* a weak RNG to generate skips */
-		pcg32_random_t skip_gen;
-		pcg32_srandom_r(&skip_gen, pcg32_random_r(&pcg), pcg32_random_r(&pcg));
-
-		/* reset the noise generator */
-		pcg32_srandom_r(&pcg, pcg_init[0], pcg_init[1]);
-
-		/* make jumps of approximately 1 Mib */
-		int const max_jump = (2<<20) / info.block_size;
-		int const step = info.block_size / sizeof(uint32_t);
-		Block::sector_t sector_offset = 0;
-		unsigned long count = 0;
-
-		/* verify the first block and loop */
-		if (!verify_block(sector_offset)) return;
-		++count;
-
-		/* random jump loop */
-		while (true) {
-			/* make a bounded random jumps */
-			Block::sector_t skip =
-				pcg32_boundedrand_r(&skip_gen, max_jump)+1;
-
-			if (sector_offset+skip >= info.block_count)
-				break;
+		float const mbytes = (float(info.block_count) * float(info.block_size)) / (1<<20);
+		log("shredding ", mbytes/(1<<10), " GiB with ", Pass::name(pass.type), " data, ",
+		    queue_depth, " packets of ", Number_of_bytes(packet_size), " in flight...");
+		auto start_ms = timer.elapsed_ms();
+
+		/* inline verification checks against the pattern of this pass */
+		written = pass.type;
+
+		process(start,
+			[&] (Block::Packet_descriptor const &region,
+			     Block::sector_t blk, size_t count)
+			{
+				Block::Packet_descriptor const pkt(
+					region, Block::Packet_descriptor::WRITE, blk, count);
+				fill(pkt, pass.type);
+				return pkt;
+			},
+			[&] (Block::Packet_descriptor const &ack,
+			     Block::Packet_descriptor &next)
+			{
+				if (ack.operation() == Block::Packet_descriptor::READ) {
+					check_read(ack);
+					return false;
+				}
+
+				if (!ack.succeeded())
+					error("ack indicates failure ", ack.block_number(),"/",info.block_count);
+
+				if (!pass.verify_inline)
+					return false;
+
+				/* read back while the region is still hot in the device cache */
+				next = sample(ack, ack.block_number(), ack.block_count(),
+				              pass.sample_interval, false);
+				return next.block_count() > 0;
+			});
+
+		float seconds = (timer.elapsed_ms() - start_ms) / 1000;
+		log("shred complete, ", mbytes / seconds, " MiB/s");
 
-			/* move the sector offset ahead */
-			sector_offset += skip;
+		if (pass.verify_inline)
+			log(verified, " blocks passed inline verification");
+	}
+
+	void verify_pass(Pass const &pass, Block::sector_t start)
+	{
+		log("verifying one in ", pass.sample_interval, " blocks...");
+		auto start_ms = timer.elapsed_ms();
 
-			/* seek the noise source ahead for the next read */
-			pcg32_advance_r(&pcg, (skip-1)*step);
+		/* regions of at least one sample interval read one block or more */
+		process(start,
+			[&] (Block::Packet_descriptor const &region,
+			     Block::sector_t blk, size_t count) {
+				return sample(region, blk, count, pass.sample_interval, true); },
+			[&] (Block::Packet_descriptor const &ack,
+			     Block::Packet_descriptor &) {
+				check_read(ack);
+				return false;
+			},
+			pass.sample_interval);
+
+		float const mbytes = (float(info.block_count) * float(info.block_size)) / (1<<20);
+		float seconds = (timer.elapsed_ms() - start_ms) / 1000;
+		log(verified, " blocks passed verification, ", mbytes / seconds, " MiB/s");
+	}
 
-			if (!verify_block(sector_offset)) return;
-			++count;
+	void run()
+	{
+		if (current_pass >= num_passes) {
+			log("all passes already complete");
+			return;
 		}
 
-		/* verify the last block */
-		pcg32_advance_r(&pcg, (info.block_count-(sector_offset+2))*step);
-		if (!verify_block(info.block_count-1)) return;
-		++count;
+		for (; current_pass < num_passes; ++current_pass) {
+
+			Pass const &pass = passes[current_pass];
+
+			/* a resumed pass continues the keystream of its checkpoint */
+			Block::sector_t const start = resume_block;
+			resume_block = 0;
+
+			if (pass.type == Pass::RANDOM && start == 0)
+				seed_noise();
+
+			if (!Pass::writes(pass.type) && written == Pass::INVALID)
+				die("no written data to verify in pass ", current_pass);
+
+			pass_start_ms    = timer.elapsed_ms();
+			pass_start_block = start;
+			verified         = 0;
+			sample_credit    = 0;
+			report(start, true);
+
+			switch (pass.type) {
+			case Pass::ZERO:
+			case Pass::RANDOM:  write_pass(pass, start);  break;
+			case Pass::VERIFY:
+			case Pass::SPOT:    verify_pass(pass, start); break;
+			case Pass::INVALID:                           break;
+			}
+		}
 
-		log(count, " blocks passed random spot check");
+		report(0, true);
 	}
 };
 
@@ -280,8 +704,7 @@ void Component::construct(Genode::Env &env)
 {
 	Blk_shred::Main main(env);
 
-	main.shred();
-	main.verify();
+	main.run();
 
 	env.parent().exit(0);
 }
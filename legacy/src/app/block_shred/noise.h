@@ -0,0 +1,200 @@
+/*
+ * \brief  Seekable ChaCha8 noise generator
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _BLOCK_SHRED__NOISE_H_
+#define _BLOCK_SHRED__NOISE_H_
+
+/* Genode includes */
+#include <util/string.h>
+#include <base/stdint.h>
+
+namespace Blk_shred {
+	using namespace Genode;
+	class Noise;
+}
+
+
+/**
+ * ChaCha8 keystream in counter mode
+ *
+ * Four consecutive ChaCha blocks are computed in parallel with one block
+ * per vector lane. The GCC vector extension is lowered to SSE2 on x86 and
+ * to NEON on ARM. The lanes are stored word by word so a chunk of
+ * 'CHUNK_SIZE' bytes holds word 0 of the four blocks, then word 1, and so
+ * on. Because the stream is a function of the chunk counter only, any
+ * chunk-aligned offset may be generated without producing the noise that
+ * precedes it.
+ */
+class Blk_shred::Noise
+{
+	public:
+
+		enum {
+			LANES      = 4,
+			BLOCK_SIZE = 64,
+			CHUNK_SIZE = BLOCK_SIZE*LANES,
+			ROUNDS     = 8,
+		};
+
+		/**
+		 * Key and nonce of the keystream
+		 */
+		struct Seed
+		{
+			uint32_t key[8];
+			uint32_t nonce[2];
+
+			void wipe() { memset(this, 0, sizeof(*this)); }
+		};
+
+	private:
+
+		typedef uint32_t Vec __attribute__((vector_size(16)));
+
+		static_assert(sizeof(Vec) == LANES*sizeof(uint32_t),
+		              "vector width does not match lane count");
+
+		uint32_t _input[16] { };
+
+		uint64_t _chunk = 0;
+
+		static inline Vec _rotl(Vec v, unsigned n) {
+			return (v << n) | (v >> (32 - n)); }
+
+		static inline void _quarter_round(Vec &a, Vec &b, Vec &c, Vec &d)
+		{
+			a += b; d ^= a; d = _rotl(d, 16);
+			c += d; b ^= c; b = _rotl(b, 12);
+			a += b; d ^= a; d = _rotl(d,  8);
+			c += d; b ^= c; b = _rotl(b,  7);
+		}
+
+		/**
+		 * Compute one chunk at the current counter and advance
+		 */
+		void _next_chunk(uint32_t *dst)
+		{
+			Vec in[16], x[16];
+
+			for (unsigned i = 0; i < 16; ++i)
+				in[i] = Vec { } + _input[i];
+
+			/* block counter of each lane */
+			uint64_t const counter = _chunk*LANES;
+			for (unsigned l = 0; l < LANES; ++l) {
+				in[12][l] = uint32_t(counter + l);
+				in[13][l] = uint32_t((counter + l) >> 32);
+			}
+
+			for (unsigned i = 0; i < 16; ++i)
+				x[i] = in[i];
+
+			for (unsigned r = 0; r < ROUNDS; r += 2) {
+				_quarter_round(x[0], x[4], x[ 8], x[12]);
+				_quarter_round(x[1], x[5], x[ 9], x[13]);
+				_quarter_round(x[2], x[6], x[10], x[14]);
+				_quarter_round(x[3], x[7], x[11], x[15]);
+
+				_quarter_round(x[0], x[5], x[10], x[15]);
+				_quarter_round(x[1], x[6], x[11], x[12]);
+				_quarter_round(x[2], x[7], x[ 8], x[13]);
+				_quarter_round(x[3], x[4], x[ 9], x[14]);
+			}
+
+			for (unsigned i = 0; i < 16; ++i) {
+				Vec const v = x[i] + in[i];
+				memcpy(&dst[i*LANES], &v, sizeof(v));
+			}
+
+			++_chunk;
+		}
+
+	public:
+
+		Noise(Seed const &seed) { rekey(seed); }
+
+		~Noise() { wipe(); }
+
+		void rekey(Seed const &seed)
+		{
+			/* "expand 32-byte k" */
+			_input[0] = 0x61707865;
+			_input[1] = 0x3320646e;
+			_input[2] = 0x79622d32;
+			_input[3] = 0x6b206574;
+
+			for (unsigned i = 0; i < 8; ++i)
+				_input[4+i] = seed.key[i];
+
+			_input[12] = 0;
+			_input[13] = 0;
+			_input[14] = seed.nonce[0];
+			_input[15] = seed.nonce[1];
+
+			_chunk = 0;
+		}
+
+		void wipe()
+		{
+			memset(_input, 0, sizeof(_input));
+			_chunk = 0;
+		}
+
+		/**
+		 * Move the stream to a byte offset
+		 *
+		 * \param offset  stream position, must be a multiple of 'CHUNK_SIZE'
+		 */
+		void seek(uint64_t offset) { _chunk = offset / CHUNK_SIZE; }
+
+		/**
+		 * Current byte offset of the stream
+		 */
+		uint64_t offset() const { return _chunk*CHUNK_SIZE; }
+
+		/**
+		 * Write noise to a buffer
+		 *
+		 * \param num_bytes  must be a multiple of 'CHUNK_SIZE'
+		 */
+		void generate(void *dst, size_t num_bytes)
+		{
+			uint32_t *words = (uint32_t *)dst;
+			for (size_t n = 0; n < num_bytes; n += CHUNK_SIZE) {
+				_next_chunk(words);
+				words += CHUNK_SIZE/sizeof(uint32_t);
+			}
+		}
+
+		/**
+		 * Compare a buffer against the noise stream
+		 *
+		 * \param num_bytes  must be a multiple of 'CHUNK_SIZE'
+		 *
+		 * \return true if the buffer matches the stream
+		 */
+		bool verify(void const *src, size_t num_bytes)
+		{
+			uint32_t expected[CHUNK_SIZE/sizeof(uint32_t)];
+
+			char const *bytes = (char const *)src;
+			for (size_t n = 0; n < num_bytes; n += CHUNK_SIZE) {
+				_next_chunk(expected);
+				if (memcmp(expected, &bytes[n], CHUNK_SIZE))
+					return false;
+			}
+			return true;
+		}
+};
+
+#endif
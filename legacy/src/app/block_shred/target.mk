@@ -1,5 +1,6 @@
 TARGET = block_shred
 LIBS   = base jitterentropy libpcg_random
 SRC_CC = main.cc
+INC_DIR = $(PRG_DIR)
 
 CC_CXX_WARN_STRICT_CONVERSION =
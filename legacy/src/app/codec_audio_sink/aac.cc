@@ -0,0 +1,164 @@
+/*
+ * \brief  AAC plug-in
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/log.h>
+
+/* FDK-AAC includes */
+#include <aacdecoder_lib.h>
+
+/* local includes */
+#include <codec.h>
+
+namespace Codec_audio_sink { class Aac_codec; }
+
+
+/**
+ * Decoder of AAC in ADTS framing
+ *
+ * The decoder is configured to mix down to at most two channels. Frames
+ * are passed to the decoder one at a time, the stream ends with the first
+ * data that is not an ADTS frame.
+ */
+class Codec_audio_sink::Aac_codec : public Codec
+{
+	private:
+
+		enum {
+			ADTS_HEADER_SIZE = 7,
+
+			/* largest frame of two channels, with SBR */
+			PCM_SAMPLES = 2048*2*2,
+		};
+
+		INT_PCM _pcm[PCM_SAMPLES];
+
+		HANDLE_AACDECODER _decoder = aacDecoder_Open(TT_MP4_ADTS, 1);
+
+		Format _format { };
+
+		AAC_DECODER_ERROR _last_err = AAC_DEC_OK;
+
+		/**
+		 * Decode the frames passed to the decoder
+		 *
+		 * \return false if the stream cannot be decoded
+		 */
+		bool _decode_frames(Output &output)
+		{
+			for (;;) {
+				AAC_DECODER_ERROR const err =
+					aacDecoder_DecodeFrame(_decoder, _pcm, PCM_SAMPLES, 0);
+
+				if (err == AAC_DEC_NOT_ENOUGH_BITS)
+					return true;
+
+				if (err != AAC_DEC_OK) {
+					if (err != _last_err)
+						error("AAC decoding failed, error ", Hex((unsigned)err));
+					_last_err = err;
+
+					/* the stream cannot be decoded with this configuration */
+					if (err >= aac_dec_init_error_start && err <= aac_dec_init_error_end)
+						return false;
+					continue;
+				}
+
+				CStreamInfo const *info = aacDecoder_GetStreamInfo(_decoder);
+				if (!info || info->sampleRate <= 0 || info->numChannels <= 0)
+					continue;
+
+				unsigned const channels = min((unsigned)info->numChannels, 2U);
+				if (channels != _format.channels || (unsigned)info->sampleRate != _format.rate) {
+					_format.channels = channels;
+					_format.rate     = info->sampleRate;
+					output.format(_format);
+				}
+
+				output.write(_pcm, info->frameSize*channels*sizeof(INT_PCM));
+			}
+		}
+
+	public:
+
+		/**
+		 * Return true if 'header' starts with an ADTS sync word and a
+		 * layer field of zero
+		 */
+		static bool adts_sync(unsigned char const *header) {
+			return header[0] == 0xff && (header[1] & 0xf6) == 0xf0; }
+
+		Aac_codec()
+		{
+			if (!_decoder) {
+				error("failed to create AAC decoder");
+				throw Exception();
+			}
+			aacDecoder_SetParam(_decoder, AAC_PCM_MAX_OUTPUT_CHANNELS, 2);
+		}
+
+		~Aac_codec() { aacDecoder_Close(_decoder); }
+
+		void decode(Input &input, Output &output) override
+		{
+			_format.encoding = Format::S16;
+			_format.channels = 0;
+
+			for (;;) {
+				unsigned char const *header = input.peek_bytes(ADTS_HEADER_SIZE);
+				if (!adts_sync(header))
+					return;
+
+				size_t const frame_len = ((header[3] & 0x3) << 11)
+				                       | (header[4] << 3) | (header[5] >> 5);
+				if (frame_len < ADTS_HEADER_SIZE)
+					return;
+
+				/* pass the whole frame, the decoder may take it in parts */
+				size_t left = frame_len;
+				while (left) {
+					UCHAR *buffer = const_cast<UCHAR *>(input.peek_bytes(left));
+					UINT   size   = (UINT)left;
+					UINT   valid  = size;
+
+					aacDecoder_Fill(_decoder, &buffer, &size, &valid);
+					input.consume(left - valid);
+					left = valid;
+
+					if (!_decode_frames(output))
+						return;
+				}
+			}
+		}
+};
+
+
+Codec_audio_sink::Codec_factory &Codec_audio_sink::aac_factory()
+{
+	struct Factory : Codec_factory
+	{
+		char const *name() const override { return "aac"; }
+
+		bool match(unsigned char const *header, size_t num_bytes) const override {
+			return num_bytes >= 2 && Aac_codec::adts_sync(header); }
+
+		Codec &create(Allocator &alloc) override {
+			return *new (alloc) Aac_codec(); }
+
+		void destroy(Allocator &alloc, Codec &codec) override {
+			Genode::destroy(alloc, static_cast<Aac_codec *>(&codec)); }
+	};
+
+	static Factory factory;
+	return factory;
+}
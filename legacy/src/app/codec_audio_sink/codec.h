@@ -0,0 +1,251 @@
+/*
+ * \brief  Interface between the sink pipeline and the codec plug-ins
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _CODEC_AUDIO_SINK__CODEC_H_
+#define _CODEC_AUDIO_SINK__CODEC_H_
+
+/* Genode includes */
+#include <base/allocator.h>
+#include <util/interface.h>
+#include <util/string.h>
+
+/* local includes */
+#include <convert.h>
+
+namespace Codec_audio_sink {
+
+	using namespace Genode;
+
+	using Raw_audio::Format;
+
+	struct Codec;
+	struct Codec_factory;
+	class  Ogg_reader;
+
+	/*
+	 * Codec plug-ins, implemented by a compilation unit each
+	 */
+	Codec_factory &mpg123_factory();
+	Codec_factory &opus_factory();
+	Codec_factory &vorbis_factory();
+	Codec_factory &flac_factory();
+	Codec_factory &aac_factory();
+
+	/**
+	 * Return true if the header starts an Ogg stream whose first packet
+	 * begins with 'magic'
+	 */
+	static inline bool ogg_first_packet_matches(unsigned char const *header,
+	                                            size_t num_bytes,
+	                                            char const *magic,
+	                                            size_t magic_len)
+	{
+		/* page header of 27 bytes followed by the segment table */
+		enum { PAGE_HEADER_SIZE = 27 };
+
+		if (num_bytes < PAGE_HEADER_SIZE || memcmp(header, "OggS", 4))
+			return false;
+
+		size_t const packet = PAGE_HEADER_SIZE + header[PAGE_HEADER_SIZE - 1];
+
+		return packet + magic_len <= num_bytes
+		    && !memcmp(&header[packet], magic, magic_len);
+	}
+}
+
+
+/**
+ * Decoder of one compressed stream
+ *
+ * A codec is run on the decoder thread. It reads compressed data from
+ * the 'Input' and writes samples to the 'Output', both of which block
+ * the thread until the client or the Audio_out session catches up.
+ *
+ * At the end of a stream, a codec must have consumed only the data of
+ * the stream, the remaining data is passed to the next codec.
+ */
+struct Codec_audio_sink::Codec : Interface
+{
+	struct Span { unsigned char const *start; size_t num_bytes; };
+
+	struct Input : Interface
+	{
+		/**
+		 * Data at 'offset' bytes after the head of the input
+		 *
+		 * Blocks until at least one byte is available at 'offset', the
+		 * offset must be less than the capacity of the input.
+		 */
+		virtual Span peek(size_t offset) = 0;
+
+		/**
+		 * Release bytes at the head of the input
+		 */
+		virtual void consume(size_t num_bytes) = 0;
+
+		/**
+		 * Total capacity of the input, the codec must consume data that
+		 * it has peeked before the peeked bytes reach the capacity
+		 */
+		virtual size_t capacity() const = 0;
+
+		/**
+		 * First 'num_bytes' at the head of the input
+		 *
+		 * The input is contiguous from its head. Blocks until the bytes
+		 * are available, 'num_bytes' must not exceed the capacity.
+		 */
+		unsigned char const *peek_bytes(size_t num_bytes)
+		{
+			size_t const last = num_bytes ? num_bytes - 1 : 0;
+			return peek(last).start - last;
+		}
+
+		/**
+		 * Copy data from the head of the input, blocks until at least
+		 * one byte is available
+		 *
+		 * \return number of bytes copied
+		 */
+		size_t read(void *dst, size_t max_bytes)
+		{
+			Span const span = peek(0);
+			size_t const n = min(span.num_bytes, max_bytes);
+			memcpy(dst, span.start, n);
+			consume(n);
+			return n;
+		}
+	};
+
+	struct Output : Interface
+	{
+		/**
+		 * Set the layout of the following samples
+		 */
+		virtual void format(Format const &) = 0;
+
+		/**
+		 * Write interleaved samples, blocks until all are buffered
+		 */
+		virtual void write(void const *samples, size_t num_bytes) = 0;
+	};
+
+	/**
+	 * Decode until the end of the stream
+	 *
+	 * The codec returns at the end of a stream whose end it can detect
+	 * or if it cannot recover from an error, the sink then detects the
+	 * format of the following data anew.
+	 */
+	virtual void decode(Input &, Output &) = 0;
+};
+
+
+/**
+ * Reader of the pages of a chain of Ogg streams
+ *
+ * Whole pages are passed to the codec library. After a page that ends a
+ * logical stream, the input ends unless the stream is followed by
+ * another one of the same codec. The data after the chain thus remains
+ * in the input.
+ */
+class Codec_audio_sink::Ogg_reader
+{
+	private:
+
+		enum { PAGE_HEADER_SIZE = 27, EOS_FLAG = 0x04 };
+
+		Codec::Input &_input;
+
+		char const *_magic;
+		size_t      _magic_len;
+
+		/* bytes of the current page that were not read yet */
+		size_t _page_left = 0;
+
+		bool _stream_ended = false;
+		bool _end          = false;
+
+		bool _start_page()
+		{
+			unsigned char const *header = _input.peek_bytes(PAGE_HEADER_SIZE);
+			if (memcmp(header, "OggS", 4))
+				return false;
+
+			size_t const segments = header[PAGE_HEADER_SIZE - 1];
+			header = _input.peek_bytes(PAGE_HEADER_SIZE + segments);
+
+			/* the next stream of a chain must be of the same codec */
+			if (_stream_ended) {
+				header = _input.peek_bytes(PAGE_HEADER_SIZE + segments + _magic_len);
+				if (!ogg_first_packet_matches(header,
+				                              PAGE_HEADER_SIZE + segments + _magic_len,
+				                              _magic, _magic_len))
+					return false;
+			}
+
+			size_t body = 0;
+			for (size_t i = 0; i < segments; ++i)
+				body += header[PAGE_HEADER_SIZE + i];
+
+			_page_left    = PAGE_HEADER_SIZE + segments + body;
+			_stream_ended = header[5] & EOS_FLAG;
+			return true;
+		}
+
+	public:
+
+		Ogg_reader(Codec::Input &input, char const *magic, size_t magic_len)
+		: _input(input), _magic(magic), _magic_len(magic_len) { }
+
+		/**
+		 * Copy data of the current page
+		 *
+		 * \return number of bytes copied, zero at the end of the chain
+		 */
+		size_t read(void *dst, size_t max_bytes)
+		{
+			if (!_page_left && !_end && !_start_page())
+				_end = true;
+
+			if (_end)
+				return 0;
+
+			size_t const n = _input.read(dst, min(max_bytes, _page_left));
+			_page_left -= n;
+			return n;
+		}
+};
+
+
+/**
+ * Recognition and creation of a codec
+ */
+struct Codec_audio_sink::Codec_factory : Interface
+{
+	/* number of bytes at the head of a stream that are passed to 'match' */
+	enum { SNIFF_BYTES = 64 };
+
+	virtual char const *name() const = 0;
+
+	/**
+	 * Return true if the stream header is of the codec's format
+	 */
+	virtual bool match(unsigned char const *header, size_t num_bytes) const = 0;
+
+	virtual Codec &create(Allocator &) = 0;
+
+	virtual void destroy(Allocator &, Codec &) = 0;
+};
+
+#endif /* _CODEC_AUDIO_SINK__CODEC_H_ */
@@ -0,0 +1,223 @@
+/*
+ * \brief  FLAC plug-in
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/log.h>
+
+/* FLAC includes */
+#include <FLAC/stream_decoder.h>
+
+/* local includes */
+#include <codec.h>
+
+namespace Codec_audio_sink { class Flac_codec; }
+
+
+/**
+ * Decoder of native FLAC streams
+ *
+ * Samples are passed on as 32-bit integers. Streams of more than two
+ * channels are reduced to the first two. If the stream info states the
+ * number of samples, decoding ends after the last sample.
+ *
+ * The decoder reads ahead, so data is only released from the input up to
+ * the end of the last decoded frame. At the end of a stream, the data
+ * that follows thus remains for the next stream.
+ */
+class Codec_audio_sink::Flac_codec : public Codec
+{
+	private:
+
+		enum { BUFFER_FRAMES = 1024 };
+
+		/* small reads keep the read-ahead beyond a frame short */
+		enum { READ_SIZE = 1 << 12 };
+
+		int32_t _pcm[BUFFER_FRAMES*2];
+
+		Input  *_input  = nullptr;
+		Output *_output = nullptr;
+
+		Format _format { };
+
+		uint64_t _total_samples   = 0;
+		uint64_t _decoded_samples = 0;
+
+		/* stream offsets of the input head and of the data read */
+		uint64_t _consumed = 0;
+		uint64_t _position = 0;
+
+		static Flac_codec &_codec(void *client_data) {
+			return *static_cast<Flac_codec *>(client_data); }
+
+		static FLAC__StreamDecoderReadStatus
+		_read(FLAC__StreamDecoder const *, FLAC__byte buffer[],
+		      size_t *bytes, void *client_data)
+		{
+			Flac_codec &codec = _codec(client_data);
+
+			/*
+			 * Data held by the decoder without a decoded frame, e.g., a
+			 * large metadata block, is released to not exhaust the input
+			 */
+			if (codec._position - codec._consumed >= codec._input->capacity() / 2) {
+				codec._input->consume(codec._position - codec._consumed);
+				codec._consumed = codec._position;
+			}
+
+			/* read ahead without releasing the data from the input */
+			Span const span = codec._input->peek(codec._position - codec._consumed);
+
+			*bytes = min(min(*bytes, span.num_bytes), (size_t)READ_SIZE);
+			memcpy(buffer, span.start, *bytes);
+			codec._position += *bytes;
+			return FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
+		}
+
+		static FLAC__StreamDecoderTellStatus
+		_tell(FLAC__StreamDecoder const *, FLAC__uint64 *offset, void *client_data)
+		{
+			*offset = _codec(client_data)._position;
+			return FLAC__STREAM_DECODER_TELL_STATUS_OK;
+		}
+
+		static FLAC__StreamDecoderWriteStatus
+		_write(FLAC__StreamDecoder const *, FLAC__Frame const *frame,
+		       FLAC__int32 const * const buffer[], void *client_data)
+		{
+			return _codec(client_data)._write_frame(*frame, buffer);
+		}
+
+		static void _metadata(FLAC__StreamDecoder const *,
+		                      FLAC__StreamMetadata const *metadata,
+		                      void *client_data)
+		{
+			if (metadata->type == FLAC__METADATA_TYPE_STREAMINFO)
+				_codec(client_data)._total_samples =
+					metadata->data.stream_info.total_samples;
+		}
+
+		static void _error(FLAC__StreamDecoder const *,
+		                   FLAC__StreamDecoderErrorStatus status, void *)
+		{
+			warning("FLAC: ", FLAC__StreamDecoderErrorStatusString[status]);
+		}
+
+		FLAC__StreamDecoderWriteStatus
+		_write_frame(FLAC__Frame const &frame, FLAC__int32 const * const buffer[])
+		{
+			FLAC__FrameHeader const &header = frame.header;
+
+			Format format { };
+			format.encoding = Format::S32;
+			format.channels = min(header.channels, 2U);
+			format.rate     = header.sample_rate;
+
+			if (format.channels != _format.channels || format.rate != _format.rate) {
+				_output->format(format);
+				_format = format;
+			}
+
+			/* scale samples to the full 32-bit range */
+			unsigned const shift    = 32 - header.bits_per_sample;
+			unsigned const channels = format.channels;
+
+			for (unsigned off = 0; off < header.blocksize; off += BUFFER_FRAMES) {
+				unsigned const n = min(header.blocksize - off, (unsigned)BUFFER_FRAMES);
+				for (unsigned i = 0; i < n; ++i)
+					for (unsigned c = 0; c < channels; ++c)
+						_pcm[i*channels + c] =
+							int32_t(uint32_t(buffer[c][off + i]) << shift);
+
+				_output->write(_pcm, n*channels*sizeof(int32_t));
+			}
+
+			_decoded_samples += header.blocksize;
+			return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+		}
+
+		/**
+		 * Release the data up to the end of the last decoded frame
+		 */
+		void _consume_decoded(FLAC__StreamDecoder *decoder)
+		{
+			FLAC__uint64 pos = 0;
+			if (!FLAC__stream_decoder_get_decode_position(decoder, &pos))
+				return;
+
+			if (pos > _consumed) {
+				_input->consume(pos - _consumed);
+				_consumed = pos;
+			}
+		}
+
+		bool _stream_complete(FLAC__StreamDecoder *decoder) const
+		{
+			if (_total_samples && _decoded_samples >= _total_samples)
+				return true;
+
+			return FLAC__stream_decoder_get_state(decoder)
+			    >= FLAC__STREAM_DECODER_END_OF_STREAM;
+		}
+
+	public:
+
+		void decode(Input &input, Output &output) override
+		{
+			_input  = &input;
+			_output = &output;
+
+			FLAC__StreamDecoder *decoder = FLAC__stream_decoder_new();
+			if (!decoder) {
+				error("failed to create FLAC decoder");
+				return;
+			}
+
+			if (FLAC__stream_decoder_init_stream(
+			    decoder, _read, nullptr, _tell, nullptr, nullptr,
+			    _write, _metadata, _error, this)
+			    == FLAC__STREAM_DECODER_INIT_STATUS_OK) {
+
+				while (FLAC__stream_decoder_process_single(decoder)) {
+					_consume_decoded(decoder);
+					if (_stream_complete(decoder))
+						break;
+				}
+			} else
+				error("failed to initialize FLAC decoder");
+
+			FLAC__stream_decoder_finish(decoder);
+			FLAC__stream_decoder_delete(decoder);
+		}
+};
+
+
+Codec_audio_sink::Codec_factory &Codec_audio_sink::flac_factory()
+{
+	struct Factory : Codec_factory
+	{
+		char const *name() const override { return "flac"; }
+
+		bool match(unsigned char const *header, size_t num_bytes) const override {
+			return num_bytes >= 4 && !memcmp(header, "fLaC", 4); }
+
+		Codec &create(Allocator &alloc) override {
+			return *new (alloc) Flac_codec(); }
+
+		void destroy(Allocator &alloc, Codec &codec) override {
+			Genode::destroy(alloc, static_cast<Flac_codec *>(&codec)); }
+	};
+
+	static Factory factory;
+	return factory;
+}
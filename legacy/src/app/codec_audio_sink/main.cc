@@ -0,0 +1,504 @@
+/*
+ * \brief  Multi-codec audio terminal sink
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <os/static_root.h>
+#include <libc/component.h>
+#include <audio_out_session/connection.h>
+#include <terminal_session/connection.h>
+#include <base/attached_rom_dataspace.h>
+#include <base/attached_ram_dataspace.h>
+#include <base/heap.h>
+#include <base/semaphore.h>
+#include <base/sleep.h>
+#include <world/spsc_magic_ring_buffer.h>
+
+/* libc includes */
+#include <pthread.h>
+
+/* local includes */
+#include <deinterleave.h>
+#include <codec.h>
+
+namespace Codec_audio_sink {
+
+	enum { LEFT, RIGHT, NUM_CHANNELS };
+
+	enum {
+		CLIENT_BUFFER_SIZE = 1 << 14, /* 16 KiB */
+
+		/* compressed data queued between the client and the decoder */
+		COMPRESSED_QUEUE_SIZE = CLIENT_BUFFER_SIZE * 4,
+	};
+
+	enum { STEREO_PERIOD = Audio_out::PERIOD*NUM_CHANNELS };
+
+	/* converted samples held by the decoder */
+	enum { PCM_RING_SIZE = STEREO_PERIOD * Audio_out::SAMPLE_SIZE * 2 };
+
+	enum { DEFAULT_LATENCY_MS = 100 };
+
+	struct Decoder;
+	struct Sink;
+
+	class Terminal_component;
+	struct Main;
+}
+
+
+/**
+ * Decoding thread
+ *
+ * The decoder detects the format at the head of the compressed-data
+ * queue and runs the matching codec. The codec pulls compressed data
+ * from the queue and pushes samples through a converter into a PCM ring
+ * that is drained by the entrypoint. The decoder sleeps while the queue
+ * is empty or the ring is full and is woken by the entrypoint after it
+ * has changed either condition. The entrypoint is notified of converted
+ * samples and freed queue space by a signal.
+ *
+ * The thread is a pthread because the codec libraries use the libc.
+ */
+struct Codec_audio_sink::Decoder : private Codec::Input,
+                                   private Codec::Output
+{
+	Decoder(Decoder const &);
+	Decoder &operator = (Decoder const &);
+
+	Genode::Env &_env;
+
+	Heap _heap { _env.ram(), _env.rm() };
+
+	/* signal to the entrypoint about decoder progress */
+	Signal_context_capability _progress_sigh;
+
+	Codec_factory *_factories[5] {
+		&opus_factory(), &vorbis_factory(), &flac_factory(),
+		&aac_factory(), &mpg123_factory() };
+
+	Spsc_magic_ring_buffer<unsigned char> _compressed {
+		_env, COMPRESSED_QUEUE_SIZE };
+
+	Spsc_magic_ring_buffer<float> _pcm { _env, PCM_RING_SIZE };
+
+	Constructible<Raw_audio::Converter> _converter { };
+
+	Format _format { };
+
+	/* the decoder sleeps at '_wakeup' */
+	bool      _idle = false;
+	Semaphore _wakeup { };
+
+	void _progress() { Signal_transmitter(_progress_sigh).submit(); }
+
+	template <typename COND>
+	void _wait_until(COND const &ready)
+	{
+		while (!ready()) {
+			__atomic_store_n(&_idle, true, __ATOMIC_SEQ_CST);
+
+			/* recheck to not miss a wakeup that preceded '_idle' */
+			if (!ready())
+				_wakeup.down();
+
+			__atomic_store_n(&_idle, false, __ATOMIC_SEQ_CST);
+		}
+	}
+
+
+	/*******************
+	 ** Codec::Input **
+	 *******************/
+
+	Codec::Span peek(size_t offset) override
+	{
+		_wait_until([&] { return _compressed.read_avail() > offset; });
+
+		return Codec::Span { _compressed.read_addr() + offset,
+		                     _compressed.read_avail() - offset };
+	}
+
+	void consume(size_t num_bytes) override
+	{
+		if (!num_bytes) return;
+
+		_compressed.drain(num_bytes);
+		_progress();
+	}
+
+	size_t capacity() const override { return _compressed.capacity(); }
+
+
+	/********************
+	 ** Codec::Output **
+	 ********************/
+
+	void format(Format const &format) override
+	{
+		if (!format.valid()) {
+			error("codec reported an unsupported format");
+			_converter.destruct();
+			return;
+		}
+
+		if (_converter.constructed()
+		 && format.encoding == _format.encoding
+		 && format.channels == _format.channels
+		 && format.rate     == _format.rate)
+			return;
+
+		_converter.construct(format, Audio_out::SAMPLE_RATE);
+		_format = format;
+	}
+
+	void write(void const *samples, size_t num_bytes) override
+	{
+		if (!_converter.constructed())
+			return;
+
+		char const *src = (char const *)samples;
+
+		size_t off = 0;
+		while (off < num_bytes) {
+			size_t const avail = _pcm.write_avail();
+			if (avail < NUM_CHANNELS) {
+				_wait_until([&] { return _pcm.write_avail() >= NUM_CHANNELS; });
+				continue;
+			}
+
+			Raw_audio::Converter::Result const result =
+				_converter->convert(&src[off], num_bytes - off,
+				                    _pcm.write_addr(), avail / NUM_CHANNELS);
+
+			off += result.consumed;
+			_pcm.fill(result.produced*NUM_CHANNELS);
+
+			if (result.produced)
+				_progress();
+			else if (!result.consumed)
+				_wait_until([&] { return _pcm.write_avail() > avail; });
+		}
+	}
+
+	/**
+	 * Find a known stream header at the head of the queue
+	 *
+	 * Data that precedes a header is dropped.
+	 */
+	Codec_factory &_sniff()
+	{
+		enum { SNIFF_BYTES = Codec_factory::SNIFF_BYTES };
+
+		bool unknown = false;
+
+		for (;;) {
+			_wait_until([&] { return _compressed.read_avail() >= SNIFF_BYTES; });
+
+			size_t const avail = _compressed.read_avail();
+			unsigned char const *data = _compressed.read_addr();
+
+			size_t skip = 0;
+			for (; skip + SNIFF_BYTES <= avail; ++skip)
+				for (Codec_factory *factory : _factories)
+					if (factory->match(&data[skip], avail - skip)) {
+						consume(skip);
+						return *factory;
+					}
+
+			if (!unknown)
+				warning("unrecognized data, searching for a stream header");
+			unknown = true;
+
+			consume(skip);
+		}
+	}
+
+	pthread_t _thread { };
+
+	static void *_entry(void *arg)
+	{
+		((Decoder *)arg)->_loop();
+		return nullptr;
+	}
+
+	void _loop()
+	{
+		for (;;) {
+			Codec_factory &factory = _sniff();
+
+			log("decoding ", factory.name(), " stream");
+
+			Codec *codec = nullptr;
+			try { codec = &factory.create(_heap); }
+			catch (...) {
+				error("failed to create ", factory.name(), " decoder");
+
+				/* search for the following header */
+				consume(1);
+				continue;
+			}
+
+			codec->decode(*this, *this);
+			factory.destroy(_heap, *codec);
+		}
+	}
+
+	Decoder(Genode::Env &env, Signal_context_capability progress_sigh)
+	:
+		_env(env), _progress_sigh(progress_sigh)
+	{ }
+
+	/**
+	 * Start the decoder thread, called by the entrypoint in libc context
+	 */
+	void start()
+	{
+		pthread_attr_t attr;
+		pthread_attr_init(&attr);
+		pthread_attr_setstacksize(&attr, 16UL * 1024 * sizeof(long));
+
+		int const err = pthread_create(&_thread, &attr, _entry, this);
+		pthread_attr_destroy(&attr);
+
+		if (err) {
+			error("failed to create decoder thread");
+			_env.parent().exit(-1);
+			Genode::sleep_forever();
+		}
+	}
+
+	/**
+	 * Wake the decoder if it is sleeping, called by the entrypoint
+	 */
+	void wakeup()
+	{
+		if (__atomic_exchange_n(&_idle, false, __ATOMIC_SEQ_CST))
+			_wakeup.up();
+	}
+
+	/**
+	 * Queue compressed data, called by the entrypoint
+	 *
+	 * \return number of bytes queued
+	 */
+	size_t queue(unsigned char const *src, size_t num_bytes)
+	{
+		size_t const n = min(num_bytes, _compressed.write_avail());
+		if (n) {
+			memcpy(_compressed.write_addr(), src, n);
+			_compressed.fill(n);
+			wakeup();
+		}
+		return n;
+	}
+
+	/**
+	 * Ring of converted samples, consumed by the entrypoint
+	 */
+	Spsc_magic_ring_buffer<float> &pcm() { return _pcm; }
+};
+
+
+/**
+ * Entrypoint side of the sink, passes decoded samples to Audio_out
+ */
+struct Codec_audio_sink::Sink
+{
+	Sink(Sink const &);
+	Sink &operator = (Sink const &);
+
+	template <typename FUNC>
+	static void for_each_channel(FUNC const &func) {
+		for (int i = 0; i < NUM_CHANNELS; ++i) func(i); }
+
+	Genode::Env &_env;
+
+	Attached_rom_dataspace _config_rom { _env, "config" };
+
+	Audio_out::Connection _out_left  { _env, "left",  true, true };
+	Audio_out::Connection _out_right { _env, "right", false, false };
+	Audio_out::Connection *_out[NUM_CHANNELS];
+
+	/**
+	 * Number of periods that may be queued at the Audio_out session
+	 */
+	unsigned _latency_periods()
+	{
+		unsigned const ms =
+			_config_rom.node().attribute_value("latency_ms",
+			                                   (unsigned)DEFAULT_LATENCY_MS);
+
+		unsigned const frames = (ms*Audio_out::SAMPLE_RATE) / 1000;
+		unsigned const periods = (frames + Audio_out::PERIOD - 1) / Audio_out::PERIOD;
+
+		return max(2U, min(periods, (unsigned)Audio_out::QUEUE_SIZE - 1));
+	}
+
+	unsigned const _max_queued = _latency_periods();
+
+	bool _started = false;
+
+	void submit_audio();
+
+	Io_signal_handler<Sink> _progress_handler {
+		_env.ep(), *this, &Sink::submit_audio };
+
+	Decoder _decoder { _env, _progress_handler };
+
+	/**
+	 * Queue client data for decoding
+	 *
+	 * Blocks only while the compressed queue is full.
+	 *
+	 * \return number of bytes queued
+	 */
+	size_t process(unsigned char const *src, size_t num_bytes)
+	{
+		while (true) {
+			if (size_t const n = _decoder.queue(src, num_bytes))
+				return n;
+			_env.ep().wait_and_dispatch_one_io_signal();
+		}
+	}
+
+	Sink(Genode::Env &env) : _env(env)
+	{
+		_out[LEFT]  = &_out_left;
+		_out[RIGHT] = &_out_right;
+		_out_left.progress_sigh(_progress_handler);
+		_decoder.start();
+	}
+};
+
+
+void Codec_audio_sink::Sink::submit_audio()
+{
+	Spsc_magic_ring_buffer<float> &pcm = _decoder.pcm();
+
+	if (!_started && pcm.read_avail() >= STEREO_PERIOD) {
+		for_each_channel([&] (int const c) {
+			_out[c]->start(); });
+		_started = true;
+	}
+
+	bool drained = false;
+
+	while (_started && pcm.read_avail() >= STEREO_PERIOD) {
+		Audio_out::Packet *p[NUM_CHANNELS];
+
+		/* resume at the next progress signal if the queue is full */
+		if (_out[LEFT]->stream()->queued() >= _max_queued)
+			break;
+
+		try { p[LEFT] = _out[LEFT]->stream()->alloc(); }
+		catch (Audio_out::Stream::Alloc_failed) { break; }
+
+		unsigned const ppos = _out[LEFT]->stream()->packet_position(p[LEFT]);
+		p[RIGHT] = _out[RIGHT]->stream()->get(ppos);
+
+		Raw_audio::deinterleave_stereo(pcm.read_addr(), p[LEFT]->content(),
+		                               p[RIGHT]->content(), Audio_out::PERIOD);
+
+		for_each_channel([&] (int const c) {
+			 _out[c]->submit(p[c]); });
+		pcm.drain(STEREO_PERIOD);
+		drained = true;
+	}
+
+	if (drained)
+		_decoder.wakeup();
+
+	if (_started && _out_left.stream()->empty()) {
+		for_each_channel([&] (int const c) {
+			_out[c]->stop(); });
+		_started = false;
+	}
+}
+
+
+class Codec_audio_sink::Terminal_component :
+	public Rpc_object<Terminal::Session, Terminal_component>
+{
+	private:
+
+		Sink &_sink;
+
+		Genode::Attached_ram_dataspace _io_buffer;
+
+	public:
+
+		Terminal_component(Genode::Env &env, Sink &sink)
+		:
+			_sink(sink),
+			_io_buffer(env.ram(), env.rm(), CLIENT_BUFFER_SIZE)
+		{ }
+
+
+		/********************************
+		 ** Terminal session interface **
+		 ********************************/
+
+		Genode::Dataspace_capability _dataspace() {
+			return _io_buffer.cap(); }
+
+		Size size() { return Size(0, 0); }
+
+		bool avail() { return false; }
+
+		Genode::size_t read(void *, Genode::size_t) { return 0; }
+		Genode::size_t _read(Genode::size_t) { return 0; }
+
+		Genode::size_t write(void const *, Genode::size_t) { return 0; }
+		Genode::size_t _write(Genode::size_t num_bytes)
+		{
+			/* sanitize argument */
+			num_bytes = Genode::min(num_bytes, _io_buffer.size());
+
+			/* queue for the decoder */
+			return _sink.process(
+				_io_buffer.local_addr<unsigned char>(), num_bytes);
+		}
+
+		void connected_sigh(Genode::Signal_context_capability cap) {
+			Genode::Signal_transmitter(cap).submit(); }
+
+		void read_avail_sigh(Genode::Signal_context_capability) { }
+
+		void size_changed_sigh(Genode::Signal_context_capability) { }
+};
+
+
+struct Codec_audio_sink::Main
+{
+	Genode::Env &_env;
+
+	Sink _sink { _env };
+
+	Terminal_component _terminal { _env, _sink };
+
+	Static_root<Terminal::Session> _terminal_root {
+		_env.ep().manage(_terminal) };
+
+	Main(Libc::Env &env) : _env(env)
+	{
+		env.parent().announce(env.ep().manage(_terminal_root));
+	}
+};
+
+
+/***************
+ ** Component **
+ ***************/
+
+void Libc::Component::construct(Libc::Env &env) {
+	static Codec_audio_sink::Main _main(env); }
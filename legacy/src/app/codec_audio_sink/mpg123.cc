@@ -0,0 +1,181 @@
+/*
+ * \brief  MPEG audio plug-in
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <audio_out_session/audio_out_session.h>
+#include <base/log.h>
+
+/* Mpg123 includes */
+#include <sys/types.h>
+#include <mpg123.h>
+
+/* local includes */
+#include <codec.h>
+
+namespace Codec_audio_sink { class Mpg123_codec; }
+
+
+/**
+ * Gapless decoder of MPEG audio
+ *
+ * Compressed data is released from the input only after the mpg123
+ * parser has passed it. At the end of a stream of known length, the
+ * data that was fed beyond the end thus remains for the next stream.
+ */
+class Codec_audio_sink::Mpg123_codec : public Codec
+{
+	private:
+
+		enum { FEED_SIZE = 1 << 14 };
+
+		mpg123_handle *_mh = nullptr;
+
+		/* last error code logged */
+		int _mh_err = MPG123_OK;
+
+		void _log_error()
+		{
+			int const code = mpg123_errcode(_mh);
+			if (code != MPG123_OK && _mh_err != code) {
+				_mh_err = code;
+				error("mpg123: ", mpg123_plain_strerror(code));
+			}
+		}
+
+	public:
+
+		Mpg123_codec()
+		{
+			int err = MPG123_OK;
+			_mh = mpg123_new(NULL, &err);
+			if (!_mh) {
+				error("mpg123 setup failed, ", mpg123_plain_strerror(err));
+				throw Exception();
+			}
+
+			mpg123_param(_mh, MPG123_ADD_FLAGS, MPG123_QUIET | MPG123_GAPLESS, 0);
+
+			/* let mpg123 resample to the Audio_out rate */
+			mpg123_param(_mh, MPG123_FORCE_RATE,
+			             Audio_out::SAMPLE_RATE, Audio_out::SAMPLE_RATE);
+			mpg123_format_none(_mh);
+			if (mpg123_format(_mh, Audio_out::SAMPLE_RATE,
+			                  MPG123_STEREO, MPG123_ENC_FLOAT_32) != MPG123_OK
+			 || mpg123_open_feed(_mh) != MPG123_OK) {
+				error("mpg123 setup failed, ", mpg123_strerror(_mh));
+				mpg123_delete(_mh);
+				throw Exception();
+			}
+		}
+
+		~Mpg123_codec()
+		{
+			mpg123_close(_mh);
+			mpg123_delete(_mh);
+		}
+
+		void decode(Input &input, Output &output) override
+		{
+			output.format(Format { Format::F32, 2, Audio_out::SAMPLE_RATE });
+
+			/* bytes at the head of the input that were fed to mpg123 */
+			size_t fed = 0;
+
+			/* stream offset of the input head */
+			::off_t offset = 0;
+
+			auto consume_parsed = [&] ()
+			{
+				::off_t const pos = mpg123_tell_stream(_mh);
+				if (pos <= offset)
+					return;
+
+				size_t const n = min((size_t)(pos - offset), fed);
+				input.consume(n);
+				fed    -= n;
+				offset += n;
+			};
+
+			for (;;) {
+				::off_t num = 0;
+				unsigned char *audio = nullptr;
+				size_t bytes = 0;
+
+				int const err = mpg123_decode_frame(_mh, &num, &audio, &bytes);
+
+				if (err == MPG123_OK || err == MPG123_NEW_FORMAT) {
+					if (bytes)
+						output.write(audio, bytes);
+					continue;
+				}
+
+				if (err == MPG123_DONE) {
+					/* end of a stream with known length */
+					consume_parsed();
+					return;
+				}
+
+				if (err != MPG123_NEED_MORE)
+					_log_error();
+
+				consume_parsed();
+
+				/* release data that mpg123 holds without parsing it */
+				if (fed == input.capacity()) {
+					input.consume(fed);
+					offset += fed;
+					fed = 0;
+				}
+
+				Span const span = input.peek(fed);
+				size_t const n = min(span.num_bytes, (size_t)FEED_SIZE);
+				if (mpg123_feed(_mh, span.start, n) != MPG123_OK)
+					_log_error();
+				fed += n;
+			}
+		}
+};
+
+
+Codec_audio_sink::Codec_factory &Codec_audio_sink::mpg123_factory()
+{
+	struct Factory : Codec_factory
+	{
+		Factory() { mpg123_init(); }
+
+		char const *name() const override { return "mpeg"; }
+
+		bool match(unsigned char const *header, size_t num_bytes) const override
+		{
+			if (num_bytes < 3)
+				return false;
+
+			if (!memcmp(header, "ID3", 3))
+				return true;
+
+			/* frame sync and a layer other than the reserved value of AAC */
+			return header[0] == 0xff
+			    && (header[1] & 0xe0) == 0xe0
+			    && (header[1] & 0x06) != 0;
+		}
+
+		Codec &create(Allocator &alloc) override {
+			return *new (alloc) Mpg123_codec(); }
+
+		void destroy(Allocator &alloc, Codec &codec) override {
+			Genode::destroy(alloc, static_cast<Mpg123_codec *>(&codec)); }
+	};
+
+	static Factory factory;
+	return factory;
+}
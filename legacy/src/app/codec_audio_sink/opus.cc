@@ -0,0 +1,99 @@
+/*
+ * \brief  Ogg Opus plug-in
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/log.h>
+
+/* Opusfile includes */
+#include <opusfile.h>
+
+/* local includes */
+#include <codec.h>
+
+namespace Codec_audio_sink { class Opus_codec; }
+
+
+/**
+ * Decoder of Ogg Opus, chained streams are decoded as one
+ *
+ * The decoding ends with the last page of the chain.
+ */
+class Codec_audio_sink::Opus_codec : public Codec
+{
+	private:
+
+		/* Opus is always decoded at 48 kHz */
+		enum { RATE = 48000, BUFFER_FRAMES = 960 };
+
+		float _pcm[BUFFER_FRAMES*2];
+
+		static int _read(void *stream, unsigned char *ptr, int nbytes) {
+			return (int)static_cast<Ogg_reader *>(stream)->read(ptr, nbytes); }
+
+	public:
+
+		void decode(Input &input, Output &output) override
+		{
+			OpusFileCallbacks const callbacks { _read, nullptr, nullptr, nullptr };
+
+			Ogg_reader reader { input, "OpusHead", 8 };
+
+			int err = 0;
+			OggOpusFile *of = op_open_callbacks(&reader, &callbacks, nullptr, 0, &err);
+			if (!of) {
+				error("failed to open Opus stream, error ", err);
+				return;
+			}
+
+			output.format(Format { Format::F32, 2, RATE });
+
+			for (;;) {
+				int const n = op_read_float_stereo(of, _pcm, BUFFER_FRAMES*2);
+
+				/* a gap in the stream is not fatal */
+				if (n == OP_HOLE)
+					continue;
+
+				if (n <= 0) {
+					if (n < 0)
+						error("Opus decoding failed, error ", n);
+					break;
+				}
+
+				output.write(_pcm, n*2*sizeof(float));
+			}
+
+			op_free(of);
+		}
+};
+
+
+Codec_audio_sink::Codec_factory &Codec_audio_sink::opus_factory()
+{
+	struct Factory : Codec_factory
+	{
+		char const *name() const override { return "opus"; }
+
+		bool match(unsigned char const *header, size_t num_bytes) const override {
+			return ogg_first_packet_matches(header, num_bytes, "OpusHead", 8); }
+
+		Codec &create(Allocator &alloc) override {
+			return *new (alloc) Opus_codec(); }
+
+		void destroy(Allocator &alloc, Codec &codec) override {
+			Genode::destroy(alloc, static_cast<Opus_codec *>(&codec)); }
+	};
+
+	static Factory factory;
+	return factory;
+}
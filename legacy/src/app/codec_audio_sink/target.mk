@@ -0,0 +1,7 @@
+TARGET  = codec_audio_sink
+LIBS   += base libc libm
+LIBS   += libmpg123 opusfile opus libogg libvorbis libFLAC fdk-aac
+SRC_CC += main.cc mpg123.cc opus.cc vorbis.cc flac.cc aac.cc
+INC_DIR = $(PRG_DIR) $(call select_from_repositories,src/app/raw_audio_sink)
+
+CC_CXX_WARN_STRICT =
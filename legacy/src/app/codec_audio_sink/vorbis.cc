@@ -0,0 +1,115 @@
+/*
+ * \brief  Ogg Vorbis plug-in
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/log.h>
+
+/* Vorbis includes */
+#define OV_EXCLUDE_STATIC_CALLBACKS
+#include <vorbis/vorbisfile.h>
+
+/* local includes */
+#include <codec.h>
+
+namespace Codec_audio_sink { class Vorbis_codec; }
+
+
+/**
+ * Decoder of Ogg Vorbis, chained streams are decoded as one
+ *
+ * Streams of more than two channels are reduced to the first two. The
+ * decoding ends with the last page of the chain.
+ */
+class Codec_audio_sink::Vorbis_codec : public Codec
+{
+	private:
+
+		enum { BUFFER_FRAMES = 1024 };
+
+		float _pcm[BUFFER_FRAMES*2];
+
+		static size_t _read(void *ptr, size_t size, size_t nmemb, void *source) {
+			return static_cast<Ogg_reader *>(source)->read(ptr, size*nmemb) / size; }
+
+	public:
+
+		void decode(Input &input, Output &output) override
+		{
+			ov_callbacks const callbacks { _read, nullptr, nullptr, nullptr };
+
+			Ogg_reader reader { input, "\x01vorbis", 7 };
+
+			OggVorbis_File vf { };
+			if (int const err = ov_open_callbacks(&reader, &vf, nullptr, 0, callbacks)) {
+				error("failed to open Vorbis stream, error ", err);
+				return;
+			}
+
+			int      link     = -1;
+			unsigned channels = 0;
+
+			for (;;) {
+				float **planes = nullptr;
+				int bitstream  = 0;
+
+				long const n = ov_read_float(&vf, &planes, BUFFER_FRAMES, &bitstream);
+
+				/* a gap in the stream is not fatal */
+				if (n == OV_HOLE)
+					continue;
+
+				if (n <= 0) {
+					if (n < 0)
+						error("Vorbis decoding failed, error ", n);
+					break;
+				}
+
+				/* the format may change with each link of a chain */
+				if (bitstream != link) {
+					vorbis_info const *info = ov_info(&vf, -1);
+					channels = min((unsigned)info->channels, 2U);
+					output.format(Format { Format::F32, channels, (unsigned)info->rate });
+					link = bitstream;
+				}
+
+				for (long i = 0; i < n; ++i)
+					for (unsigned c = 0; c < channels; ++c)
+						_pcm[i*channels + c] = planes[c][i];
+
+				output.write(_pcm, n*channels*sizeof(float));
+			}
+
+			ov_clear(&vf);
+		}
+};
+
+
+Codec_audio_sink::Codec_factory &Codec_audio_sink::vorbis_factory()
+{
+	struct Factory : Codec_factory
+	{
+		char const *name() const override { return "vorbis"; }
+
+		bool match(unsigned char const *header, size_t num_bytes) const override {
+			return ogg_first_packet_matches(header, num_bytes, "\x01vorbis", 7); }
+
+		Codec &create(Allocator &alloc) override {
+			return *new (alloc) Vorbis_codec(); }
+
+		void destroy(Allocator &alloc, Codec &codec) override {
+			Genode::destroy(alloc, static_cast<Vorbis_codec *>(&codec)); }
+	};
+
+	static Factory factory;
+	return factory;
+}
@@ -0,0 +1,219 @@
+/*
+ * \brief  FLIF decoder thread
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _FLIF_VIEW__DECODER_H_
+#define _FLIF_VIEW__DECODER_H_
+
+/* FLIF includes */
+#include <flif_dec.h>
+
+/* Genode includes */
+#include <base/env.h>
+#include <base/log.h>
+#include <base/signal.h>
+#include <base/semaphore.h>
+#include <base/sleep.h>
+
+/* libc includes */
+#include <pthread.h>
+
+namespace Flif_view {
+	using namespace Genode;
+	class Decoder;
+}
+
+
+/**
+ * Thread that decodes a FLIF image from memory
+ *
+ * The entrypoint starts a decode and is signaled when a preview is
+ * available or when the decode is complete. While a preview is shown
+ * the thread is blocked, so the image of the decoder may be read by the
+ * entrypoint until 'resume' is called. The thread does no I/O, the image
+ * data is read into memory by the entrypoint beforehand.
+ *
+ * The thread is a pthread because libflif allocates from and calls into
+ * the libc.
+ */
+class Flif_view::Decoder
+{
+	public:
+
+		enum State { IDLE, DECODING, PREVIEW, DONE };
+
+		/* quality of the first preview, in units of 0.01 percent */
+		enum { FIRST_PREVIEW_QUALITY = 100, FULL_QUALITY = 10000 };
+
+	private:
+
+		Signal_transmitter _progress;
+
+		Semaphore _start  { };
+		Semaphore _resume { };
+
+		FLIF_DECODER *_flif_dec = nullptr;
+
+		void const *_data = nullptr;
+		size_t      _size = 0;
+
+		bool _progressive = false;
+		bool _success     = false;
+
+		int  _state = IDLE;
+		bool _abort = false;
+
+		void _set_state(State state) {
+			__atomic_store_n(&_state, int(state), __ATOMIC_SEQ_CST); }
+
+		bool _aborted() const {
+			return __atomic_load_n(&_abort, __ATOMIC_SEQ_CST); }
+
+		static ::uint32_t _callback(::uint32_t quality, ::int64_t,
+		                            ::uint8_t decode_over,
+		                            void *user_data, void *context)
+		{
+			Decoder &decoder = *(Decoder *)user_data;
+
+			if (decoder._aborted()) {
+				flif_abort_decoder(decoder._flif_dec);
+				return 0;
+			}
+
+			/* the final image is signaled by the completion of the decode */
+			if (!decoder._progressive || decode_over)
+				return FULL_QUALITY;
+
+			flif_decoder_generate_preview(context);
+
+			decoder._set_state(PREVIEW);
+			decoder._progress.submit();
+			decoder._resume.down();
+
+			if (decoder._aborted()) {
+				flif_abort_decoder(decoder._flif_dec);
+				return 0;
+			}
+
+			/* refine quickly at first, the early passes are cheap */
+			return min(quality*2, ::uint32_t(FULL_QUALITY));
+		}
+
+		pthread_t _thread { };
+
+		static void *_entry(void *arg)
+		{
+			((Decoder *)arg)->_loop();
+			return nullptr;
+		}
+
+		void _loop()
+		{
+			for (;;) {
+				_start.down();
+
+				_success = flif_decoder_decode_memory(_flif_dec, _data, _size);
+
+				_set_state(DONE);
+				_progress.submit();
+			}
+		}
+
+	public:
+
+		/**
+		 * Constructor, called by the entrypoint in libc context
+		 */
+		Decoder(Env &env, Signal_context_capability progress_sigh)
+		:
+			_progress(progress_sigh)
+		{
+			pthread_attr_t attr;
+			pthread_attr_init(&attr);
+			pthread_attr_setstacksize(&attr, sizeof(addr_t) << 15);
+
+			int const err = pthread_create(&_thread, &attr, _entry, this);
+			pthread_attr_destroy(&attr);
+
+			if (err) {
+				error("failed to create decoder thread");
+				env.parent().exit(-1);
+				sleep_forever();
+			}
+		}
+
+		State state() const {
+			return State(__atomic_load_n(&_state, __ATOMIC_SEQ_CST)); }
+
+		bool idle() const { return state() == IDLE; }
+
+		/**
+		 * Decode an image on the thread
+		 *
+		 * The decoder and data must remain valid until the decode is
+		 * complete.
+		 */
+		void start(FLIF_DECODER *flif_dec, void const *data, size_t size,
+		           bool progressive)
+		{
+			_flif_dec    = flif_dec;
+			_data        = data;
+			_size        = size;
+			_progressive = progressive;
+			_success     = false;
+
+			__atomic_store_n(&_abort, false, __ATOMIC_SEQ_CST);
+
+			flif_decoder_set_callback(flif_dec, &_callback, this);
+			flif_decoder_set_first_callback_quality(flif_dec, FIRST_PREVIEW_QUALITY);
+
+			_set_state(DECODING);
+			_start.up();
+		}
+
+		/**
+		 * Continue decoding after a preview has been shown
+		 */
+		void resume()
+		{
+			if (state() != PREVIEW)
+				return;
+
+			_set_state(DECODING);
+			_resume.up();
+		}
+
+		/**
+		 * Abort the current decode at the next progress callback
+		 */
+		void abort()
+		{
+			__atomic_store_n(&_abort, true, __ATOMIC_SEQ_CST);
+			resume();
+		}
+
+		/**
+		 * Acknowledge a completed decode
+		 *
+		 * \return true if the image was decoded completely
+		 */
+		bool finish()
+		{
+			if (state() != DONE)
+				return false;
+
+			_set_state(IDLE);
+			return _success && !_aborted();
+		}
+};
+
+#endif
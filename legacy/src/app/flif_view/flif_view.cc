@@ -21,20 +21,21 @@
 #include <base/attached_rom_dataspace.h>
 #include <gui_session/connection.h>
 #include <util/misc_math.h>
-#include <nitpicker_gfx/texture_painter.h>
 #include <timer_session/connection.h>
 #include <base/attached_dataspace.h>
 #include <util/reconstructible.h>
-#include <os/texture_rgb888.h>
+#include <os/pixel_rgb888.h>
 
-/* gems includes */
-#include <gems/texture_utils.h>
-#include <gems/chunky_texture.h>
+/* local includes */
+#include <decoder.h>
 
 /* libc includes */
 #include <libc/component.h>
 extern "C" {
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
@@ -55,9 +56,13 @@ struct Flif_view::Main
 	Main(Main const &);
 	Main &operator = (Main const &);
 
+	typedef Pixel_rgb888 PT;
+
 	Libc::Env &env;
 
-	Attached_ram_dataspace back_ds { env.ram(), env.rm(), 0 };
+	/* image file, decoded from memory by the decoder thread */
+	Attached_ram_dataspace file_ds { env.ram(), env.rm(), 0 };
+	size_t file_size = 0;
 
 	Gui::Connection gui { env };
 
@@ -67,6 +72,12 @@ struct Flif_view::Main
 	Signal_handler<Main> app_handler {
 		env.ep(), *this, &Main::handle_app_signal };
 
+	Signal_handler<Main> progress_handler {
+		env.ep(), *this, &Main::handle_progress_signal };
+
+	Signal_handler<Main> info_handler {
+		env.ep(), *this, &Main::handle_info };
+
 	Io_signal_handler<Main> input_handler {
 		env.ep(), *this, &Main::handle_input_signal };
 
@@ -75,15 +86,18 @@ struct Flif_view::Main
 
 	Mode gui_mode { };
 
-	Surface_base::Area img_area { };
+	Gui::Area img_area { };
+
+	/* images larger than the window are decoded at a reduced scale */
+	Gui::Area window_area { };
 
 	Constructible<Attached_dataspace> nit_ds { };
 
-	template <typename PT>
-	void apply_to_texture(unsigned width, unsigned height, auto const &fn)
+	void buffer(unsigned width, unsigned height)
 	{
 		if (gui_mode.area.w < width || gui_mode.area.h < height) {
-			Mode new_mode { .area  = { width, height },
+			Mode new_mode { .area  = { max(width,  gui_mode.area.w),
+			                           max(height, gui_mode.area.h) },
 			                .alpha = false };
 			log("resize gui buffer to ", new_mode);
 			if (nit_ds.constructed())
@@ -96,15 +110,6 @@ struct Flif_view::Main
 			gui.buffer(gui_mode);
 			nit_ds.construct(env.rm(), gui.framebuffer.dataspace());
 		}
-
-		size_t const buffer_size = gui_mode.num_bytes();
-
-		if (buffer_size > back_ds.size())
-			back_ds.realloc(&env.ram(), buffer_size);
-
-		Texture<PT> texture(back_ds.local_addr<PT>(), nullptr, gui_mode.area);
-
-		fn(texture);
 	}
 
 	Attached_rom_dataspace config_rom { env, "config" };
@@ -122,6 +127,8 @@ struct Flif_view::Main
 
 	FLIF_DECODER *flif_dec = NULL;
 
+	Decoder decoder { env, progress_handler };
+
 	struct dirent **namelist = NULL;
 	int page_count = 0;
 
@@ -129,45 +136,76 @@ struct Flif_view::Main
 	int pending_page_index = 0;
 	int cur_frame = 0;
 
+	/* direction to skip pages that fail to decode */
+	int direction = 1;
+	int failures  = 0;
+
+	/* the current decode was aborted to show another page */
+	bool aborting = false;
+	bool restart  = false;
+
 	unsigned long last_ms = 0;
 
 	bool progressive = false;
 	bool verbose = false;
 
-	bool render_page();
+	bool read_file(char const *filename);
+
+	bool start_page();
 
-	void next_page()
+	void show_page()
 	{
-		while (true) {
-			++cur_page_index;
-			if (cur_page_index > page_count-1)
-				cur_page_index = 0;
-			if (render_page())
-				break;
+		if (page_count < 1)
+			return;
+
+		/* the decoder owns the file buffer until it is done */
+		if (!decoder.idle()) {
+			restart = true;
+			abort_decode();
+			return;
 		}
+
+		if (!start_page())
+			step_page(direction);
 	}
 
-	void prev_page()
+	void step_page(int dir)
 	{
-		while (true) {
-			--cur_page_index;
-			if (cur_page_index < 0)
-				cur_page_index = page_count-1;
-			if (render_page())
-				break;
+		direction = dir;
+		for (int i = 0; i < page_count; ++i) {
+			cur_page_index = (cur_page_index + dir + page_count) % page_count;
+			if (start_page())
+				return;
 		}
 	}
 
+	void abort_decode()
+	{
+		if (decoder.idle() || aborting)
+			return;
+
+		aborting = true;
+		decoder.abort();
+	}
+
 	void handle_app_signal()
 	{
-		if (cur_page_index < pending_page_index) {
-			Libc::with_libc([&] () { next_page(); });
-		} else
-		if (cur_page_index > pending_page_index) {
-			Libc::with_libc([&] () { prev_page(); });
+		if (cur_page_index == pending_page_index)
+			return;
+
+		/* navigate when the current decode has stopped */
+		if (!decoder.idle()) {
+			abort_decode();
+			return;
 		}
+
+		failures = 0;
+		int const dir = (cur_page_index < pending_page_index) ? 1 : -1;
+		Libc::with_libc([&] () { step_page(dir); });
 	}
 
+	void handle_progress_signal();
+
 	void handle_config()
 	{
 		progressive = config_rom.xml().attribute_value(
@@ -175,6 +213,12 @@ struct Flif_view::Main
 		verbose = config_rom.xml().attribute_value(
 			"verbose", verbose);
 
+		/* a decode of the old page list must not complete */
+		if (!decoder.idle()) {
+			restart = true;
+			abort_decode();
+		}
+
 		while (page_count > 0) {
 			--page_count;
 			free(namelist[page_count]);
@@ -185,8 +229,14 @@ struct Flif_view::Main
 		}
 
 		page_count = scandir(".", &namelist, NULL, alphasort);
+		if (page_count < 0)
+			page_count = 0;
+
+		if (cur_page_index >= page_count)
+			cur_page_index = 0;
 
-		render_page();
+		failures = 0;
+		show_page();
 	}
 
 	void handle_config_signal()
@@ -195,6 +245,19 @@ struct Flif_view::Main
 		Libc::with_libc([&] () { handle_config(); });
 	}
 
+	/**
+	 * Track the window size, applied to the next decoded page
+	 */
+	void handle_info()
+	{
+		window_area = gui.window().convert<Gui::Area>(
+			[&] (Gui::Rect rect) { return rect.area; },
+			[&] (Gui::Undefined) {
+				return gui.panorama().convert<Gui::Area>(
+					[&] (Gui::Rect rect) { return rect.area; },
+					[&] (Gui::Undefined) { return Gui::Area { }; }); });
+	}
+
 	/**
 	 * I/O handler for input. May interrupt rendering during I/O
 	 * dispatch because the application is not executed from
@@ -217,38 +280,79 @@ struct Flif_view::Main
 	Main(Libc::Env &env) : env(env)
 	{
 		gui.input.sigh(input_handler);
+		gui.info_sigh(info_handler);
 		config_rom.sigh(config_handler);
 
+		handle_info();
 		handle_config();
 	}
 };
 
 
-static ::uint32_t progressive_render(::uint32_t quality, ::int64_t bytes_read, ::uint8_t /*decode_over*/, void *user_data, void *context)
+void Flif_view::Main::handle_progress_signal()
 {
-	auto *main = (Flif_view::Main*)user_data;
+	switch (decoder.state()) {
+
+	case Decoder::PREVIEW:
+		/* show the preview while the decoder is blocked */
+		if (!aborting)
+			render(flif_decoder_get_image(flif_dec, 0));
+		decoder.resume();
+		return;
+
+	case Decoder::DONE:
+		break;
 
-	if (main->verbose) {
-		unsigned long const now_ms = main->timer.elapsed_ms();
-		double dur_s = double(now_ms - main->last_ms) / 1000.0;
-		main->last_ms = now_ms;
-		Genode::log((double(bytes_read) / (1 << 20)) / dur_s, " MiB/s");
+	case Decoder::IDLE:
+	case Decoder::DECODING:
+		return;
 	}
 
-	if (main->progressive) {
-		flif_decoder_generate_preview(context);
+	bool const success = decoder.finish();
 
-		FLIF_IMAGE *img = flif_decoder_get_image(main->flif_dec, 0);
-		main->render(img);
+	if (aborting) {
+		aborting = false;
+		if (restart || cur_page_index == pending_page_index) {
+			restart = false;
+			Libc::with_libc([&] () { show_page(); });
+		} else {
+			handle_app_signal();
+		}
+		return;
 	}
 
-	/* abort decoding if input has moved the page index */
-	if (main->cur_page_index != main->pending_page_index) {
-		flif_abort_decoder(main->flif_dec);
-		return 0;
+	if (cur_page_index >= page_count)
+		return;
+
+	char const *filename = namelist[cur_page_index]->d_name;
+
+	if (!success) {
+		error("decode '", filename, "' failed");
+		if (++failures < page_count)
+			Libc::with_libc([&] () { step_page(direction); });
+		return;
+	}
+
+	failures = 0;
+
+	if (verbose) {
+		unsigned long const now_ms = timer.elapsed_ms();
+		double dur_s = double(now_ms - last_ms) / 1000.0;
+		log((double(file_size) / (1 << 20)) / dur_s, " MiB/s");
+	}
+
+	log(filename);
+
+	FLIF_IMAGE *img = flif_decoder_get_image(flif_dec, 0);
+	render(img);
+
+	if (flif_decoder_num_images(flif_dec) > 1) {
+		render_timeout.schedule(
+			Microseconds(flif_image_get_frame_delay(img)));
 	}
 
-	return ++quality;
+	/* input may have arrived during the decode */
+	handle_app_signal();
 }
 
 
@@ -263,32 +367,35 @@ void Flif_view::Main::render_animation(Duration)
 }
 
 
-void Flif_view::Main::render(FLIF_IMAGE *img)
+/**
+ * Convert RGBA8 pixels to RGB888 in place
+ */
+static inline void rgba_to_rgb888(Genode::Pixel_rgb888 *pixels, unsigned count)
 {
-	int const f_width  = flif_image_get_width(img);
-	int const f_height = flif_image_get_height(img);
+	unsigned char const *src = (unsigned char const *)pixels;
+	for (unsigned i = 0; i < count; ++i, src += 4)
+		pixels[i] = Genode::Pixel_rgb888(src[0], src[1], src[2]);
+}
 
-	typedef Pixel_rgb888 PT;
-	apply_to_texture<PT>(f_width, f_height, [&] (Texture<PT> &texture) {
-		/* fill texture with FLIF image data */
-		char row[f_width*4];
-		for (int y = 0; y < f_height; ++y) {
-			flif_image_read_row_RGBA8(img, y, &row, sizeof(row));
-			texture.rgba((unsigned char*)&row, f_width, y);
-		}
-	});
 
-	/* flush to surface on next sync signal */
-	img_area = Surface_base::Area(f_width, f_height);
+void Flif_view::Main::render(FLIF_IMAGE *img)
+{
+	unsigned const f_width  = flif_image_get_width(img);
+	unsigned const f_height = flif_image_get_height(img);
+
+	buffer(f_width, f_height);
 
-	using PT = Pixel_rgb888;
+	/* read rows directly into the GUI buffer */
+	PT *pixels = nit_ds->local_addr<PT>();
+	for (unsigned y = 0; y < f_height; ++y) {
+		PT *row = &pixels[y*gui_mode.area.w];
+		flif_image_read_row_RGBA8(img, y, row, f_width*sizeof(PT));
+		rgba_to_rgb888(row, f_width);
+	}
 
-	Texture<PT> texture(back_ds.local_addr<PT>(), nullptr, gui_mode.area);
-	Surface<PT> surface(nit_ds->local_addr<PT>(), gui_mode.area);
+	img_area = Gui::Area(f_width, f_height);
 
-	Texture_painter::paint(
-		surface, texture, Color(), Surface_base::Point(),
-		Texture_painter::SOLID, true);
+	gui.framebuffer.refresh({ { 0, 0 }, img_area });
 
 	gui.enqueue<Command::Geometry>(view.id(), Gui::Rect(Gui::Point(), img_area));
 	gui.enqueue<Command::Front>(view.id());
@@ -296,42 +403,67 @@ void Flif_view::Main::render(FLIF_IMAGE *img)
 }
 
 
-bool Flif_view::Main::render_page()
+bool Flif_view::Main::read_file(char const *filename)
+{
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st { };
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < 1) {
+		close(fd);
+		return false;
+	}
+
+	file_size = st.st_size;
+	if (file_size > file_ds.size())
+		file_ds.realloc(&env.ram(), file_size);
+
+	char *buf = file_ds.local_addr<char>();
+	size_t offset = 0;
+	while (offset < file_size) {
+		ssize_t n = read(fd, &buf[offset], file_size - offset);
+		if (n < 1)
+			break;
+		offset += n;
+	}
+	close(fd);
+
+	return offset == file_size;
+}
+
+
+bool Flif_view::Main::start_page()
 {
 	pending_page_index = cur_page_index;
 
 	struct dirent *d = namelist[cur_page_index];
 	char const *filename = d->d_name;
 
+	if (!read_file(filename))
+		return false;
+
+	/* the animation of the previous page reads from its decoder */
+	render_timeout.discard();
+	cur_frame = 0;
+
 	if (flif_dec != NULL) {
 		flif_destroy_decoder(flif_dec);
 		flif_dec = NULL;
 	}
 
 	flif_dec = flif_create_decoder();
-	flif_decoder_set_resize(flif_dec, gui_mode.area.w, gui_mode.area.h);
-	flif_decoder_set_callback(flif_dec, &(progressive_render), this);
+
+	/* decode at the largest power-of-two scale that fits the window */
+	if (window_area.valid())
+		flif_decoder_set_resize(flif_dec, window_area.w, window_area.h);
 
 	gui.enqueue<Gui::Session::Command::Title>(view.id(), filename);
 
 	if (verbose)
 		last_ms = timer.elapsed_ms();
 
-	if (!flif_decoder_decode_file(flif_dec, filename)) {
-		error("decode '", filename, "' failed");
-		return false;
-	}
-
-	log(filename);
-
-	FLIF_IMAGE *img = flif_decoder_get_image(flif_dec, 0);
-	render(img);
-
-	if (flif_decoder_num_images(flif_dec) > 1) {
-		render_timeout.schedule(
-			Microseconds(flif_image_get_frame_delay(img)));
-	}
-
+	decoder.start(flif_dec, file_ds.local_addr<void>(), file_size, progressive);
 	return true;
 }
 
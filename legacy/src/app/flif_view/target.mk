@@ -1,5 +1,6 @@
 TARGET += flif_view
 LIBS += base libflif libc blit stdcxx
 SRC_CC = flif_view.cc
+INC_DIR += $(PRG_DIR)
 
 CC_CXX_WARN_STRICT =
@@ -13,9 +13,7 @@
 
 /*
  * TODO:
- * - Metadata report
  * - Configure the mpg123 volume control and equalizer
- * - Optimize buffer sizes
  */
 
 /* Genode includes */
@@ -25,7 +23,14 @@
 #include <terminal_session/connection.h>
 #include <base/attached_rom_dataspace.h>
 #include <base/attached_ram_dataspace.h>
+#include <timer_session/connection.h>
+#include <base/mutex.h>
+#include <base/semaphore.h>
 #include <base/sleep.h>
+#include <world/spsc_magic_ring_buffer.h>
+
+/* libc includes */
+#include <pthread.h>
 
 /* Mpg123 includes */
 #include <stdlib.h>
@@ -33,7 +38,8 @@
 #include <mpg123.h>
 
 /* local includes */
-#include <magic_ring_buffer.h>
+#include <deinterleave.h>
+#include <stats.h>
 
 namespace Mp3_audio_sink {
 
@@ -42,6 +48,9 @@ namespace Mp3_audio_sink {
 	enum {
 		FEED_POOL_SIZE = 2,
 		CLIENT_BUFFER_SIZE = 1 << 14, /* 16 KiB */
+
+		/* compressed data queued between the client and the decoder */
+		COMPRESSED_QUEUE_SIZE = CLIENT_BUFFER_SIZE * 4,
 	};
 
 	enum {
@@ -51,28 +60,50 @@ namespace Mp3_audio_sink {
 			* Audio_out::SAMPLE_SIZE
 	};
 
+	enum { STEREO_PERIOD = Audio_out::PERIOD*NUM_CHANNELS };
+
+	enum { DEFAULT_LATENCY_MS = 100, DEFAULT_REPORT_INTERVAL_MS = 1000 };
+
 	using namespace Genode;
 
 	struct Decoder;
+	struct Sink;
 
 	class Terminal_component;
 	struct Main;
 }
 
 
+/**
+ * Decoding thread
+ *
+ * The decoder consumes compressed data from a queue filled by the
+ * entrypoint and produces interleaved samples into a ring that is
+ * drained by the entrypoint. Both rings have a single producer and a
+ * single consumer so no locking is needed to pass data. The decoder
+ * sleeps while the queue is empty or the ring is full and is woken by
+ * the entrypoint after it has changed either condition. The entrypoint
+ * is notified of decoded samples and freed queue space by a signal.
+ *
+ * The thread is a pthread because it calls into mpg123 and thereby the
+ * libc. The mpg123 handle is only accessed by this thread once it runs.
+ */
 struct Mp3_audio_sink::Decoder
 {
-	template <typename FUNC>
-	static void for_each_channel(FUNC const &func) {
-		for (int i = 0; i < NUM_CHANNELS; ++i) func(i); }
+	Decoder(Decoder const &);
+	Decoder &operator = (Decoder const &);
 
 	Genode::Env &_env;
 
-	Attached_rom_dataspace _config_rom { _env, "config" };
+	Attached_rom_dataspace &_config_rom;
 
-	Audio_out::Connection _out_left  { _env, "left",  true, true };
-	Audio_out::Connection _out_right { _env, "right", false, false };
-	Audio_out::Connection *_out[NUM_CHANNELS];
+	/* protects the config ROM from updates during import */
+	Mutex _config_mutex { };
+
+	bool _config_pending = false;
+
+	/* signal to the entrypoint about decoder progress */
+	Signal_context_capability _progress_sigh;
 
 	void die_mpg123(mpg123_handle *mh, char const *msg)
 	{
@@ -95,9 +126,22 @@ struct Mp3_audio_sink::Decoder
 		if(err != MPG123_OK || (mh = mpg123_new(NULL, &err)) == NULL)
 			Genode::error("Mpg123 setup failed, ", mpg123_plain_strerror(err));
 
+		/*
+		 * Errors are logged by the decoder, which has no stdio. Gapless
+		 * decoding trims the encoder delay and padding stated in the
+		 * LAME/Info header of a stream.
+		 */
+		mpg123_param(mh, MPG123_ADD_FLAGS, MPG123_QUIET | MPG123_GAPLESS, 0);
+
 		mpg123_param(mh, MPG123_FEEDPOOL, FEED_POOL_SIZE, 0);
 		mpg123_param(mh, MPG123_FEEDBUFFER, CLIENT_BUFFER_SIZE, 0);
 
+		/* interval of ICY metadata in a stream from a shoutcast server */
+		long const icy_interval =
+			_config_rom.node().attribute_value("icy_interval", 0L);
+		if (icy_interval)
+			mpg123_param(mh, MPG123_ICY_INTERVAL, icy_interval, 0);
+
 		/* Set mpg123 output format to match Audio_out exactly */
 		mpg123_param(mh, MPG123_FORCE_RATE,
 		             Audio_out::SAMPLE_RATE, Audio_out::SAMPLE_RATE);
@@ -116,22 +160,60 @@ struct Mp3_audio_sink::Decoder
 	/* last error code logged */
 	int _mh_err = MPG123_OK;
 
-	/**
-	 * Use half of the available RAM as buffer
-	 */
-	size_t _pcm_buffer_size()
+	/* size of the buffer for client data, queried before the thread starts */
+	size_t const _feedbuffer_size = _query_feedbuffer_size();
+
+	size_t _query_feedbuffer_size()
 	{
-		size_t n = _env.pd().avail_ram().value / 2;
-		if (n > (1<<20))
-			log("internal buffer size is ", n>>20, "MiB");
-		else if (n > (1<<10))
-			log("internal buffer size is ", n>>10, "KiB");
-		else
-			log("internal buffer size is ", n, " bytes");
-		return n;
+		long value = 0;
+		double fvalue = 0;
+		if (mpg123_getparam(_mh, MPG123_FEEDBUFFER, &value, &fvalue))
+			die_mpg123(_mh, "failed to get feed buffer size");
+		return value;
 	}
 
-	Magic_ring_buffer<float> _pcm { _env, _pcm_buffer_size() };
+	/* samples of the largest frame that mpg123 may decode */
+	size_t const _max_frame_samples = mpg123_outblock(_mh) / Audio_out::SAMPLE_SIZE;
+
+	/*
+	 * The PCM ring holds a decoded frame and a partial period, the
+	 * remaining latency is spent at the Audio_out queue
+	 */
+	size_t _pcm_buffer_size() const {
+		return (_max_frame_samples + STEREO_PERIOD) * Audio_out::SAMPLE_SIZE; }
+
+	/*
+	 * Compressed data is retained in the queue until the mpg123 parser
+	 * has passed it. At the end of a gapless stream, the data that was
+	 * fed beyond the end is thus available to the next stream.
+	 */
+	Spsc_magic_ring_buffer<unsigned char> _compressed {
+		_env, COMPRESSED_QUEUE_SIZE };
+
+	Spsc_magic_ring_buffer<float> _pcm { _env, _pcm_buffer_size() };
+
+	/* bytes at the head of the queue that were fed to mpg123 */
+	size_t _fed = 0;
+
+	/* stream offset of the queue head */
+	::off_t _stream_offset = 0;
+
+	/* the decoder waits for more compressed data */
+	bool _starved = false;
+
+	/* protects the statistics and metadata from concurrent access */
+	Mutex _stats_mutex { };
+
+	Decode_stats _stats    { };
+	Metadata     _metadata { };
+
+	bool _metadata_changed = false;
+
+	size_t _unfed() const { return _compressed.read_avail() - _fed; }
+
+	/* the decoder sleeps at '_wakeup' */
+	bool      _idle = false;
+	Semaphore _wakeup { };
 
 	void _log_error()
 	{
@@ -142,134 +224,559 @@ struct Mp3_audio_sink::Decoder
 		}
 	}
 
-	Genode::size_t feedbuffer_size()
+	void _apply_config()
 	{
-		long value = 0;
-		double fvalue = 0;
-		if (mpg123_getparam(_mh, MPG123_FEEDBUFFER, &value, &fvalue))
-			die_mpg123(_mh, "failed to get feed buffer size");
-		return value;
+		Mutex::Guard guard(_config_mutex);
+
+		Node const config = _config_rom.node();
+
+		enum { EQ_COUNT = 32 };
+
+		mpg123_reset_eq(_mh);
+		config.for_each_sub_node("eq", [&] (Node const &node) {
+			unsigned band = node.attribute_value("band", 32U);
+			double value = node.attribute_value("value", 0.0);
+			if (band < EQ_COUNT && value != 0.0) {
+				mpg123_eq(_mh, MPG123_LR , band, value);
+				log("EQ ", band, ": ", mpg123_geteq(_mh, MPG123_LR , band));
+			}
+		});
+
+		double volume = 0.5;
+		config.for_each_sub_node("volume", [&] (Node const &node) {
+			volume = node.attribute_value("linear", volume); });
+		mpg123_volume(_mh, volume);
 	}
 
-	void submit_audio();
+	void _record_frame(Trace::Timestamp ticks)
+	{
+		mpg123_frameinfo info { };
+		mpg123_info(_mh, &info);
+
+		Mutex::Guard guard(_stats_mutex);
+		_stats.record_frame(ticks, info.bitrate, info.rate);
+	}
+
+	void _import_metadata()
+	{
+		int const meta = mpg123_meta_check(_mh);
+		if (!(meta & (MPG123_NEW_ID3 | MPG123_NEW_ICY)))
+			return;
+
+		Mutex::Guard guard(_stats_mutex);
+
+		mpg123_id3v1 *v1 = nullptr;
+		mpg123_id3v2 *v2 = nullptr;
+		if ((meta & MPG123_NEW_ID3) && mpg123_id3(_mh, &v1, &v2) == MPG123_OK) {
+
+			/* prefer ID3v2 text, ID3v1 fields are not terminated */
+			auto text = [&] (mpg123_string const *v2_text,
+			                 char const *v1_text, size_t v1_len)
+			{
+				if (v2_text && v2_text->p && v2_text->fill)
+					return Metadata::Text(Cstring(v2_text->p, v2_text->fill));
+				if (v1_text)
+					return Metadata::Text(Cstring(v1_text, v1_len));
+				return Metadata::Text();
+			};
+
+			_metadata.title  = text(v2 ? v2->title  : nullptr,
+			                        v1 ? v1->title  : nullptr, sizeof(v1->title));
+			_metadata.artist = text(v2 ? v2->artist : nullptr,
+			                        v1 ? v1->artist : nullptr, sizeof(v1->artist));
+			_metadata.album  = text(v2 ? v2->album  : nullptr,
+			                        v1 ? v1->album  : nullptr, sizeof(v1->album));
+			_metadata.year   = text(v2 ? v2->year   : nullptr,
+			                        v1 ? v1->year   : nullptr, sizeof(v1->year));
+			_metadata.genre  = text(v2 ? v2->genre  : nullptr, nullptr, 0);
+		}
+
+		char *icy = nullptr;
+		if ((meta & MPG123_NEW_ICY) && mpg123_icy(_mh, &icy) == MPG123_OK && icy)
+			_metadata.icy = Metadata::Icy_text(Cstring(icy));
+
+		__atomic_store_n(&_metadata_changed, true, __ATOMIC_SEQ_CST);
+	}
+
+	/**
+	 * Drain the data that mpg123 has parsed from the queue
+	 *
+	 * \return true if any data was drained
+	 */
+	bool _drain_parsed()
+	{
+		::off_t const pos = mpg123_tell_stream(_mh);
+		if (pos <= _stream_offset)
+			return false;
+
+		size_t const n = min((size_t)(pos - _stream_offset), _fed);
+		_compressed.drain(n);
+		_fed -= n;
+		_stream_offset += n;
+		return n > 0;
+	}
 
 	/**
-	 * Process client data, blocks until all data is consumed.
+	 * Restart mpg123 for a following stream
+	 *
+	 * The data fed beyond the end of the previous stream is fed again.
 	 */
-	void process(unsigned char const *src, size_t num_bytes)
+	void _next_stream()
 	{
-		/* TODO: patch mpgg123 not to use stdio for printing errors */
+		_drain_parsed();
+
+		mpg123_close(_mh);
+		if (mpg123_open_feed(_mh) != MPG123_OK)
+			die_mpg123(_mh, "mpg123 feeder mode failed");
 
-		Libc::with_libc([&] () {
+		_fed = 0;
+		_stream_offset = 0;
+
+		Mutex::Guard guard(_stats_mutex);
+		++_stats.streams;
+		_metadata = Metadata();
+		__atomic_store_n(&_metadata_changed, true, __ATOMIC_SEQ_CST);
+	}
 
-			/* feed client data into mpg123 buffer */
-			if (mpg123_feed(_mh, src, num_bytes))
-				die_mpg123(_mh, "failed to feed");
+	/**
+	 * Decode as long as there is input and room for output
+	 *
+	 * \return true if any data was consumed or produced
+	 */
+	bool _decode()
+	{
+		bool progress = false;
 
+		while (_pcm.write_avail() >= _max_frame_samples) {
 			::off_t num = 0;
 			unsigned char *audio = nullptr;
 			size_t bytes = 0;
 
-			while (mpg123_decode_frame(_mh, &num, &audio, &bytes) == MPG123_OK) {
-				Genode::size_t const samples = bytes / Audio_out::SAMPLE_SIZE;
+			Trace::Timestamp const start = Trace::timestamp();
+
+			int const err = mpg123_decode_frame(_mh, &num, &audio, &bytes);
 
-				while (_pcm.write_avail() < samples) {
-					/* submit audio blocks for packet allocation */
-					submit_audio();
+			if (err == MPG123_OK || err == MPG123_NEW_FORMAT) {
+				if (bytes) {
+					_record_frame(Trace::timestamp() - start);
+					memcpy(_pcm.write_addr(), audio, bytes);
+					_pcm.fill(bytes / Audio_out::SAMPLE_SIZE);
+					progress = true;
 				}
+				_import_metadata();
+				continue;
+			}
+
+			if (err == MPG123_DONE) {
+				/* end of a stream with known length */
+				_next_stream();
+				progress = true;
+				continue;
+			}
 
-				Genode::memcpy(_pcm.write_addr(), audio, bytes);
-				_pcm.fill(samples);
+			if (err != MPG123_NEED_MORE) {
+				_log_error();
 
+				Mutex::Guard guard(_stats_mutex);
+				++_stats.errors;
 			}
 
-			if (mpg123_errcode(_mh) != MPG123_ERR_READER
-			 || mpg123_errcode(_mh) != MPG123_OK)
+			if (_drain_parsed())
+				progress = true;
+
+			/*
+			 * If mpg123 holds the whole queue without parsing it, the
+			 * data is dropped from the queue to make room for the client
+			 */
+			if (!_unfed() && !_compressed.write_avail()) {
+				_compressed.drain(_fed);
+				_stream_offset += _fed;
+				_fed = 0;
+				progress = true;
+			}
+
+			/* feed mpg123 from the queue, one buffer at a time */
+			size_t const n = min(_unfed(), (size_t)CLIENT_BUFFER_SIZE);
+			if (!n) {
+				_starved = true;
+				break;
+			}
+
+			if (mpg123_feed(_mh, _compressed.read_addr() + _fed, n) != MPG123_OK)
 				_log_error();
-		});
+			_fed += n;
+			_starved = false;
+			progress = true;
+		}
+
+		return progress;
 	}
 
-	Io_signal_handler<Decoder> _progress_handler {
-		_env.ep(), *this, &Decoder::submit_audio };
+	bool _blocked() const
+	{
+		return (_pcm.write_avail() < _max_frame_samples)
+		    || (_starved && !_unfed());
+	}
+
+	void _wait()
+	{
+		__atomic_store_n(&_idle, true, __ATOMIC_SEQ_CST);
 
-	Signal_handler<Decoder> _config_handler {
-		_env.ep(), *this, &Decoder::_handle_config };
+		/* recheck to not miss a wakeup that preceded '_idle' */
+		if (_blocked() && !__atomic_load_n(&_config_pending, __ATOMIC_SEQ_CST))
+			_wakeup.down();
 
-	void _handle_config()
+		__atomic_store_n(&_idle, false, __ATOMIC_SEQ_CST);
+	}
+
+	pthread_t _thread { };
+
+	static void *_entry(void *arg)
 	{
-		_config_rom.update();
-		Xml_node const config = _config_rom.xml();
+		((Decoder *)arg)->_loop();
+		return nullptr;
+	}
 
-		enum { EQ_COUNT = 32 };
+	void _loop()
+	{
+		for (;;) {
+			if (__atomic_exchange_n(&_config_pending, false, __ATOMIC_SEQ_CST))
+				_apply_config();
+
+			if (_decode())
+				Signal_transmitter(_progress_sigh).submit();
+			else
+				_wait();
+		}
+	}
 
-		mpg123_reset_eq(_mh);
-		config.for_each_sub_node("eq", [&] (Xml_node const &node) {
-			unsigned band = node.attribute_value("band", 32U);
-			double value = node.attribute_value("value", 0.0);
-			if (band < EQ_COUNT && value != 0.0) {
-				mpg123_eq(_mh, MPG123_LR , band, value);
-				log("EQ ", band, ": ", mpg123_geteq(_mh, MPG123_LR , band));
-			}
-		});
+	Decoder(Genode::Env &env, Attached_rom_dataspace &config_rom,
+	        Signal_context_capability progress_sigh)
+	:
+		_env(env), _config_rom(config_rom), _progress_sigh(progress_sigh)
+	{
+		_apply_config();
+	}
 
-		double volume = 0.5;
-		config.for_each_sub_node("volume", [&] (Xml_node const &node) {
-			volume = node.attribute_value("linear", volume); });
-		mpg123_volume(_mh, 0.5);
+	/**
+	 * Start the decoder thread, called by the entrypoint in libc context
+	 */
+	void start()
+	{
+		pthread_attr_t attr;
+		pthread_attr_init(&attr);
+		pthread_attr_setstacksize(&attr, 16UL * 1024 * sizeof(long));
+
+		int const err = pthread_create(&_thread, &attr, _entry, this);
+		pthread_attr_destroy(&attr);
+
+		if (err) {
+			error("failed to create decoder thread");
+			_env.parent().exit(-1);
+			Genode::sleep_forever();
+		}
+	}
+
+	/**
+	 * Wake the decoder if it is sleeping, called by the entrypoint
+	 */
+	void wakeup()
+	{
+		if (__atomic_exchange_n(&_idle, false, __ATOMIC_SEQ_CST))
+			_wakeup.up();
+	}
+
+	/**
+	 * Update the config, called by the entrypoint
+	 */
+	void update_config()
+	{
+		{
+			Mutex::Guard guard(_config_mutex);
+			_config_rom.update();
+		}
+		__atomic_store_n(&_config_pending, true, __ATOMIC_SEQ_CST);
+		wakeup();
+	}
+
+	/**
+	 * Queue compressed data, called by the entrypoint
+	 *
+	 * \return number of bytes queued
+	 */
+	size_t queue(unsigned char const *src, size_t num_bytes)
+	{
+		size_t const n = min(num_bytes, _compressed.write_avail());
+		if (n) {
+			memcpy(_compressed.write_addr(), src, n);
+			_compressed.fill(n);
+			wakeup();
+		}
+		return n;
+	}
+
+	/**
+	 * Ring of decoded samples, consumed by the entrypoint
+	 */
+	Spsc_magic_ring_buffer<float> &pcm() { return _pcm; }
+
+	/**
+	 * Number of compressed bytes queued, called by the entrypoint
+	 */
+	size_t queued_bytes() const {
+		return _compressed.capacity() - _compressed.write_avail(); }
+
+	template <typename FN>
+	void with_stats(FN const &fn)
+	{
+		Mutex::Guard guard(_stats_mutex);
+		fn(_stats, _metadata);
 	}
 
-	Decoder(Genode::Env &env) : _env(env)
+	/**
+	 * Return true once after the metadata has changed
+	 */
+	bool metadata_changed() {
+		return __atomic_exchange_n(&_metadata_changed, false, __ATOMIC_SEQ_CST); }
+
+	Genode::size_t feedbuffer_size() const { return _feedbuffer_size; }
+};
+
+
+/**
+ * Entrypoint side of the sink, passes decoded samples to Audio_out
+ */
+struct Mp3_audio_sink::Sink
+{
+	Sink(Sink const &);
+	Sink &operator = (Sink const &);
+
+	template <typename FUNC>
+	static void for_each_channel(FUNC const &func) {
+		for (int i = 0; i < NUM_CHANNELS; ++i) func(i); }
+
+	Genode::Env &_env;
+
+	Attached_rom_dataspace _config_rom { _env, "config" };
+
+	Audio_out::Connection _out_left  { _env, "left",  true, true };
+	Audio_out::Connection _out_right { _env, "right", false, false };
+	Audio_out::Connection *_out[NUM_CHANNELS];
+
+	/**
+	 * Number of periods that may be queued at the Audio_out session
+	 */
+	unsigned _latency_periods()
+	{
+		unsigned const ms =
+			_config_rom.node().attribute_value("latency_ms",
+			                                  (unsigned)DEFAULT_LATENCY_MS);
+
+		unsigned const frames = (ms*Audio_out::SAMPLE_RATE) / 1000;
+		unsigned const periods = (frames + Audio_out::PERIOD - 1) / Audio_out::PERIOD;
+
+		return max(2U, min(periods, (unsigned)Audio_out::QUEUE_SIZE - 1));
+	}
+
+	unsigned const _max_queued = _latency_periods();
+
+	bool _started = false;
+
+	unsigned long _underruns = 0;
+
+	Constructible<Expanding_reporter> _stats_reporter    { };
+	Constructible<Expanding_reporter> _metadata_reporter { };
+
+	Timer::Connection _timer { _env };
+
+	/* timestamp ticks per microsecond measured between reports */
+	uint64_t         _last_us    = _timer.elapsed_us();
+	Trace::Timestamp _last_ticks = Trace::timestamp();
+	uint64_t         _ticks_per_us = 0;
+
+	void _report_stats();
+	void _report_metadata();
+
+	Signal_handler<Sink> _timer_handler {
+		_env.ep(), *this, &Sink::_report_stats };
+
+	void submit_audio();
+
+	Io_signal_handler<Sink> _progress_handler {
+		_env.ep(), *this, &Sink::submit_audio };
+
+	Signal_handler<Sink> _config_handler {
+		_env.ep(), *this, &Sink::_handle_config };
+
+	Decoder _decoder { _env, _config_rom, _progress_handler };
+
+	void _handle_config() { _decoder.update_config(); }
+
+	/**
+	 * Queue client data for decoding
+	 *
+	 * Blocks only while the compressed queue is full.
+	 *
+	 * \return number of bytes queued
+	 */
+	size_t process(unsigned char const *src, size_t num_bytes)
+	{
+		while (true) {
+			if (size_t const n = _decoder.queue(src, num_bytes))
+				return n;
+			_env.ep().wait_and_dispatch_one_io_signal();
+		}
+	}
+
+	Genode::size_t feedbuffer_size() const { return _decoder.feedbuffer_size(); }
+
+	Sink(Genode::Env &env) : _env(env)
 	{
 		_out[LEFT]  = &_out_left;
 		_out[RIGHT] = &_out_right;
 		_out_left.progress_sigh(_progress_handler);
 		_config_rom.sigh(_config_handler);
-		_handle_config();
+
+		_config_rom.node().for_each_sub_node("report", [&] (Node const &node) {
+			if (node.attribute_value("metadata", false))
+				_metadata_reporter.construct(_env, "metadata", "metadata");
+
+			if (node.attribute_value("stats", false)) {
+				_stats_reporter.construct(_env, "stats", "stats");
+
+				uint64_t const ms =
+					node.attribute_value("interval_ms",
+					                     (uint64_t)DEFAULT_REPORT_INTERVAL_MS);
+				_timer.sigh(_timer_handler);
+				_timer.trigger_periodic(max(ms, (uint64_t)10)*1000);
+			}
+		});
+
+		_decoder.start();
 	}
 };
 
 
-void Mp3_audio_sink::Decoder::submit_audio()
+void Mp3_audio_sink::Sink::_report_metadata()
 {
-	using namespace Audio_out;
+	if (!_metadata_reporter.constructed())
+		return;
 
-	enum { STEREO_PERIOD = Audio_out::PERIOD*NUM_CHANNELS };
+	/* report a copy to not hold up the decoder */
+	Metadata metadata { };
+	_decoder.with_stats([&] (Decode_stats const &, Metadata const &m) {
+		metadata = m; });
 
-	if (_out_left.stream()->empty()) {
+	_metadata_reporter->generate([&] (Generator &g) {
+		metadata.generate(g); });
+}
+
+
+void Mp3_audio_sink::Sink::_report_stats()
+{
+	if (!_stats_reporter.constructed())
+		return;
+
+	uint64_t         const now_us    = _timer.elapsed_us();
+	Trace::Timestamp const now_ticks = Trace::timestamp();
+	if (now_us > _last_us && now_ticks > _last_ticks) {
+		_ticks_per_us = max((now_ticks - _last_ticks) / (now_us - _last_us),
+		                    (Trace::Timestamp)1);
+		_last_us    = now_us;
+		_last_ticks = now_ticks;
+	}
+
+	auto us = [&] (Trace::Timestamp ticks) {
+		return _ticks_per_us ? ticks / _ticks_per_us : 0; };
+
+	auto ms_of_samples = [&] (size_t samples) {
+		return (samples/NUM_CHANNELS*1000) / Audio_out::SAMPLE_RATE; };
+
+	size_t const pcm_samples    = _decoder.pcm().read_avail();
+	size_t const queued_samples = _out_left.stream()->queued()*STEREO_PERIOD;
+	size_t const queued_bytes   = _decoder.queued_bytes();
+
+	/* report a copy to not hold up the decoder */
+	Decode_stats stats { };
+	_decoder.with_stats([&] (Decode_stats const &s, Metadata const &) {
+		stats = s; });
+
+	Decode_stats::Percentiles const decode_time = stats.percentiles();
+
+	_stats_reporter->generate([&] (Generator &g) {
+		g.attribute("frames",    stats.frames);
+		g.attribute("streams",   stats.streams);
+		g.attribute("errors",    stats.errors);
+		g.attribute("underruns", _underruns);
+		g.attribute("bitrate_kbps", stats.bitrate);
+		g.attribute("rate",         stats.rate);
+
+		g.node("decode_time_us", [&] {
+			g.attribute("p50", us(decode_time.p50));
+			g.attribute("p90", us(decode_time.p90));
+			g.attribute("p99", us(decode_time.p99));
+			g.attribute("max", us(decode_time.max));
+		});
+
+		g.node("buffer", [&] {
+			g.attribute("compressed_bytes", queued_bytes);
+			g.attribute("pcm_ms",    ms_of_samples(pcm_samples));
+			g.attribute("queued_ms", ms_of_samples(queued_samples));
+			g.attribute("latency_ms",
+			            (_max_queued*Audio_out::PERIOD*1000)/Audio_out::SAMPLE_RATE);
+		});
+	});
+}
+
+
+void Mp3_audio_sink::Sink::submit_audio()
+{
+	Spsc_magic_ring_buffer<float> &pcm = _decoder.pcm();
+
+	if (!_started && pcm.read_avail() >= STEREO_PERIOD) {
 		for_each_channel([&] (int const c) {
 			_out[c]->start(); });
+		_started = true;
 		log("Audio_out streams started");
 	}
 
-	while (_pcm.read_avail() > STEREO_PERIOD) {
+	bool drained = false;
+
+	while (_started && pcm.read_avail() >= STEREO_PERIOD) {
 		Audio_out::Packet *p[NUM_CHANNELS];
 
-		while (true) {
-			try { p[LEFT] = _out[LEFT]->stream()->alloc(); break; }
-			catch (Audio_out::Stream::Alloc_failed) {
-				_out[LEFT]->wait_for_alloc(); }
-		}
+		/* resume at the next progress signal if the queue is full */
+		if (_out[LEFT]->stream()->queued() >= _max_queued)
+			break;
+
+		try { p[LEFT] = _out[LEFT]->stream()->alloc(); }
+		catch (Audio_out::Stream::Alloc_failed) { break; }
 
 		unsigned const ppos = _out[LEFT]->stream()->packet_position(p[LEFT]);
 		p[RIGHT] = _out[RIGHT]->stream()->get(ppos);
 
-		float const *content = _pcm.read_addr();
-
 		/* copy channel contents into sessions */
-		for (unsigned i = 0; i < STEREO_PERIOD; i += NUM_CHANNELS) {
-			for_each_channel([&] (int const c) {
-				p[c]->content()[i/NUM_CHANNELS] = content[i+c]; });
-		}
+		Raw_audio::deinterleave_stereo(pcm.read_addr(), p[LEFT]->content(),
+		                               p[RIGHT]->content(), Audio_out::PERIOD);
 
 		for_each_channel([&] (int const c) {
 			 _out[c]->submit(p[c]); });
-		_pcm.drain(STEREO_PERIOD);
+		pcm.drain(STEREO_PERIOD);
+		drained = true;
 	}
 
-	if (_out_left.stream()->empty()) {
+	if (drained)
+		_decoder.wakeup();
+
+	if (_decoder.metadata_changed())
+		_report_metadata();
+
+	if (_started && _out_left.stream()->empty()) {
 		log("Audio_out queue underrun, stopping stream");
 		for_each_channel([&] (int const c) {
 			_out[c]->stop(); });
+		_started = false;
+		++_underruns;
 	}
 }
 
@@ -279,16 +786,16 @@ class Mp3_audio_sink::Terminal_component :
 {
 	private:
 
-		Decoder &_decoder;
+		Sink &_sink;
 
 		Genode::Attached_ram_dataspace _io_buffer;
 
 	public:
 
-		Terminal_component(Genode::Env &env, Decoder &decoder)
+		Terminal_component(Genode::Env &env, Sink &sink)
 		:
-			_decoder(decoder),
-			_io_buffer(env.ram(), env.rm(), _decoder.feedbuffer_size())
+			_sink(sink),
+			_io_buffer(env.ram(), env.rm(), _sink.feedbuffer_size())
 		{ }
 
 
@@ -312,11 +819,9 @@ class Mp3_audio_sink::Terminal_component :
 			/* sanitize argument */
 			num_bytes = Genode::min(num_bytes, _io_buffer.size());
 
-			/* copy to decoder */
-			_decoder.process(
+			/* queue for the decoder */
+			return _sink.process(
 				_io_buffer.local_addr<unsigned char>(), num_bytes);
-
-			return num_bytes;
 		}
 
 		void connected_sigh(Genode::Signal_context_capability cap) {
@@ -332,9 +837,9 @@ struct Mp3_audio_sink::Main
 {
 	Genode::Env &_env;
 
-	Decoder _decoder { _env };
+	Sink _sink { _env };
 
-	Terminal_component _terminal { _env, _decoder };
+	Terminal_component _terminal { _env, _sink };
 
 	Static_root<Terminal::Session> _terminal_root {
 		_env.ep().manage(_terminal) };
@@ -0,0 +1,118 @@
+/*
+ * \brief  Decoder statistics and stream metadata
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _MP3_AUDIO_SINK__STATS_H_
+#define _MP3_AUDIO_SINK__STATS_H_
+
+/* Genode includes */
+#include <trace/timestamp.h>
+#include <util/string.h>
+#include <os/reporter.h>
+
+namespace Mp3_audio_sink {
+
+	using namespace Genode;
+
+	struct Decode_stats;
+	struct Metadata;
+}
+
+
+/**
+ * Figures recorded by the decoder thread
+ *
+ * The decode time of the most recent frames is kept in timestamp ticks,
+ * the ticks are converted to microseconds by the entrypoint, which
+ * measures the tick rate against its timer.
+ */
+struct Mp3_audio_sink::Decode_stats
+{
+	enum { SAMPLES = 256 };
+
+	Trace::Timestamp decode_ticks[SAMPLES] { };
+
+	unsigned long frames  = 0;
+	unsigned long streams = 0;
+	unsigned long errors  = 0;
+
+	/* properties of the last frame */
+	int  bitrate = 0;
+	long rate    = 0;
+
+	void record_frame(Trace::Timestamp ticks, int frame_bitrate, long frame_rate)
+	{
+		decode_ticks[frames % SAMPLES] = ticks;
+		++frames;
+		bitrate = frame_bitrate;
+		rate    = frame_rate;
+	}
+
+	struct Percentiles { Trace::Timestamp p50, p90, p99, max; };
+
+	/**
+	 * Decode-time percentiles of the recorded frames
+	 */
+	Percentiles percentiles() const
+	{
+		unsigned const n = (unsigned)min(frames, (unsigned long)SAMPLES);
+		if (!n)
+			return Percentiles { 0, 0, 0, 0 };
+
+		Trace::Timestamp sorted[SAMPLES];
+		for (unsigned i = 0; i < n; ++i) {
+			Trace::Timestamp const t = decode_ticks[i];
+			unsigned j = i;
+			for (; j > 0 && sorted[j-1] > t; --j)
+				sorted[j] = sorted[j-1];
+			sorted[j] = t;
+		}
+
+		auto at = [&] (unsigned pct) { return sorted[((n - 1)*pct)/100]; };
+
+		return Percentiles { at(50), at(90), at(99), sorted[n - 1] };
+	}
+};
+
+
+/**
+ * ID3 and ICY metadata of the current stream
+ */
+struct Mp3_audio_sink::Metadata
+{
+	typedef String<128> Text;
+	typedef String<256> Icy_text;
+
+	Text title  { };
+	Text artist { };
+	Text album  { };
+	Text year   { };
+	Text genre  { };
+
+	Icy_text icy { };
+
+	void generate(Generator &g) const
+	{
+		auto text = [&] (char const *type, auto const &value) {
+			if (value.valid())
+				g.node(type, [&] { g.attribute("value", value); }); };
+
+		text("title",  title);
+		text("artist", artist);
+		text("album",  album);
+		text("year",   year);
+		text("genre",  genre);
+		text("icy",    icy);
+	}
+};
+
+#endif /* _MP3_AUDIO_SINK__STATS_H_ */
@@ -16,10 +16,14 @@
 #include <terminal_session/connection.h>
 #include <os/static_root.h>
 #include <base/attached_ram_dataspace.h>
+#include <base/attached_rom_dataspace.h>
 #include <base/component.h>
+#include <os/reporter.h>
+#include <world/spsc_magic_ring_buffer.h>
 
 /* local includes */
-#include <magic_ring_buffer.h>
+#include <deinterleave.h>
+#include <convert.h>
 
 namespace Raw_audio {
 	using namespace Genode;
@@ -32,6 +36,16 @@ namespace Raw_audio {
 			* Audio_out::SAMPLE_SIZE
 			* NUM_CHANNELS };
 
+	enum {
+		STEREO_PERIOD = Audio_out::PERIOD*NUM_CHANNELS,
+		STEREO_CHUNK  = STEREO_PERIOD * Audio_out::SAMPLE_SIZE
+	};
+
+	enum { DEFAULT_LATENCY_MS = 40 };
+
+	/* periods submitted between two stats reports, about 0.75 s */
+	enum { STATS_REPORT_PERIODS = 64 };
+
 	struct Sink;
 	class Terminal_component;
 	struct Main;
@@ -49,43 +63,242 @@ struct Raw_audio::Sink
 
 	Genode::Env &_env;
 
+	Attached_rom_dataspace _config_rom { _env, "config" };
+
 	Audio_out::Connection _out_left  { _env, "left",  true };
 	Audio_out::Connection _out_right { _env, "right", false };
 	Audio_out::Connection *_out[NUM_CHANNELS];
 
-	size_t _buffer_size()
+	/**
+	 * Number of periods that may be queued at the Audio_out session
+	 */
+	unsigned _latency_periods()
+	{
+		unsigned const ms =
+			_config_rom.node().attribute_value("latency_ms",
+			                                   (unsigned)DEFAULT_LATENCY_MS);
+
+		unsigned const frames = (ms*Audio_out::SAMPLE_RATE) / 1000;
+		unsigned const periods = (frames + Audio_out::PERIOD - 1) / Audio_out::PERIOD;
+
+		return max(2U, min(periods, (unsigned)Audio_out::QUEUE_SIZE - 1));
+	}
+
+	unsigned const _max_queued = _latency_periods();
+
+	/*
+	 * The ring only holds a partial period and the periods that did
+	 * not fit into the packet queue, the latency is thus bounded by the
+	 * queue limit plus one period
+	 */
+	Spsc_magic_ring_buffer<char> _pcm { _env, STEREO_CHUNK*2 };
+
+	bool _started = false;
+
+	unsigned long _underruns = 0;
+
+	/* submitted periods, used to rate-limit the stats report */
+	unsigned long _periods          = 0;
+	unsigned long _reported_periods = 0;
+	bool          _stats_changed    = false;
+
+	Constructible<Expanding_reporter> _stats_reporter { };
+
+	Format _client_format()
 	{
-		size_t n = AUDIO_OUT_BUFFER_SIZE;
-		enum { RESERVATION = AUDIO_OUT_BUFFER_SIZE+((sizeof(addr_t)*16)<<10) };
-		Ram_quota avail = _env.pd().avail_ram();
-		if (avail.value > RESERVATION)
-			n = avail.value - RESERVATION;
-		return n;
+		Node const config = _config_rom.node();
+
+		Format format { };
+		format.encoding = Format::encoding_of(
+			config.attribute_value("format", Format::Name("f32")));
+		format.channels = config.attribute_value("channels", 2U);
+		format.rate     = config.attribute_value("rate",
+		                                         (unsigned)Audio_out::SAMPLE_RATE);
+		return format;
 	}
 
-	Magic_ring_buffer<char> _pcm { _env, _buffer_size() };
+	Format const _format = _client_format();
+
+	/* conversion stage, used unless the client writes the Audio_out format */
+	Constructible<Converter> _converter { };
 
 	/**
-	 * Process client data, blocks until all data is consumed.
+	 * Report changed stats at most once per 'STATS_REPORT_PERIODS'
 	 */
-	void process(char const *src, size_t num_bytes)
+	void _report_stats(bool force = false)
+	{
+		if (!_stats_reporter.constructed())
+			return;
+
+		if (!force && (!_stats_changed
+		            || _periods - _reported_periods < STATS_REPORT_PERIODS))
+			return;
+
+		_stats_changed    = false;
+		_reported_periods = _periods;
+
+		_stats_reporter->generate([&] (Generator &g) {
+			g.attribute("latency_ms",
+			            (_max_queued*Audio_out::PERIOD*1000)/Audio_out::SAMPLE_RATE);
+			g.attribute("underruns", _underruns);
+		});
+	}
+
+	void _start()
+	{
+		if (_started) return;
+
+		for_each_channel([&] (int const c) {
+			 _out[c]->start(); });
+		_started = true;
+	}
+
+	void _stop()
+	{
+		for_each_channel([&] (int const c) {
+			 _out[c]->stop(); });
+		_started = false;
+	}
+
+	/**
+	 * Submit one period of interleaved samples
+	 *
+	 * \return false if the queue holds the maximum number of periods
+	 */
+	bool _submit_period(float const *content)
+	{
+		if (_out[LEFT]->stream()->queued() >= _max_queued)
+			return false;
+
+		Audio_out::Packet *p[NUM_CHANNELS];
+
+		try { p[LEFT] = _out[LEFT]->stream()->alloc(); }
+		catch (Audio_out::Stream::Alloc_failed) { return false; }
+
+		unsigned const ppos = _out[LEFT]->stream()->packet_position(p[LEFT]);
+		p[RIGHT] = _out[RIGHT]->stream()->get(ppos);
+
+		/* split channel contents straight into the sessions */
+		deinterleave_stereo(content, p[LEFT]->content(), p[RIGHT]->content(),
+		                    Audio_out::PERIOD);
+
+		for_each_channel([&] (int const c) {
+			 _out[c]->submit(p[c]); });
+		++_periods;
+		return true;
+	}
+
+	/**
+	 * Submit the whole periods buffered in the ring
+	 */
+	void _drain_ring()
+	{
+		while (_pcm.read_avail() >= STEREO_CHUNK) {
+			if (!_submit_period((float const *)_pcm.read_addr()))
+				return;
+			_pcm.drain(STEREO_CHUNK);
+		}
+	}
+
+	/**
+	 * Consume as much client data as the latency bound permits
+	 *
+	 * \return number of bytes consumed
+	 */
+	size_t _consume(char const *src, size_t num_bytes)
 	{
 		size_t remain = num_bytes;
 		size_t off = 0;
-		while (remain > 0) {
-			if (_pcm.read_avail() < Audio_out::SAMPLE_SIZE)
-				for_each_channel([&] (int const c) {
-					 _out[c]->start(); });
-
-			char *dst = _pcm.write_addr();
-			size_t const n = min(remain, _pcm.write_avail());
-			memcpy(dst, &src[off], n);
+
+		/* complete a period that is pending in the ring */
+		size_t const pending = _pcm.read_avail() % STEREO_CHUNK;
+		if (pending && remain >= STEREO_CHUNK - pending
+		 && _pcm.write_avail() >= STEREO_CHUNK - pending) {
+			size_t const n = STEREO_CHUNK - pending;
+			memcpy(_pcm.write_addr(), src, n);
 			_pcm.fill(n);
 			off += n;
 			remain -= n;
+		}
 
-			if (_pcm.write_avail() < remain)
-				_env.ep().wait_and_dispatch_one_io_signal();
+		if (_pcm.read_avail() >= STEREO_CHUNK) {
+			_start();
+			_drain_ring();
+		}
+
+		/*
+		 * Submit whole periods from the client buffer without copying
+		 * them to the ring as long as the packet queue has room
+		 */
+		if (_pcm.read_avail() == 0 && remain >= STEREO_CHUNK
+		 && ((addr_t)&src[off] % sizeof(float)) == 0) {
+
+			_start();
+			while (remain >= STEREO_CHUNK
+			    && _submit_period((float const *)&src[off])) {
+				off += STEREO_CHUNK;
+				remain -= STEREO_CHUNK;
+			}
+		}
+
+		/* buffer what does not fit into the queue */
+		size_t const n = min(remain, _pcm.write_avail());
+		if (n) {
+			memcpy(_pcm.write_addr(), &src[off], n);
+			_pcm.fill(n);
+			off += n;
+		}
+
+		return off;
+	}
+
+	/**
+	 * Convert client data into the ring
+	 *
+	 * \return number of bytes consumed
+	 */
+	size_t _consume_converted(char const *src, size_t num_bytes)
+	{
+		enum { FRAME_SIZE = NUM_CHANNELS*Audio_out::SAMPLE_SIZE };
+
+		size_t off = 0;
+		while (true) {
+			Converter::Result const result =
+				_converter->convert(&src[off], num_bytes - off,
+				                    (float *)_pcm.write_addr(),
+				                    _pcm.write_avail() / FRAME_SIZE);
+			off += result.consumed;
+			_pcm.fill(result.produced*FRAME_SIZE);
+
+			if (_pcm.read_avail() >= STEREO_CHUNK) {
+				_start();
+				_drain_ring();
+			}
+
+			if (!result.consumed && !result.produced)
+				return off;
+		}
+	}
+
+	/**
+	 * Process client data
+	 *
+	 * A write is consumed partially if it exceeds the latency bound and
+	 * the client retries with the remainder. Blocks only while the queue
+	 * and the ring are completely full, which lasts at most one period,
+	 * as the client would otherwise retry without pause.
+	 *
+	 * \return number of bytes consumed
+	 */
+	size_t process(char const *src, size_t num_bytes)
+	{
+		while (true) {
+			size_t const n = _converter.constructed()
+			               ? _consume_converted(src, num_bytes)
+			               : _consume(src, num_bytes);
+			if (n || !num_bytes)
+				return n;
+			_env.ep().wait_and_dispatch_one_io_signal();
 		}
 	}
 
@@ -100,48 +313,43 @@ struct Raw_audio::Sink
 		_out[RIGHT] = &_out_right;
 
 		_out_left.progress_sigh(_progress_handler);
-	}
-};
-
-
-void Raw_audio::Sink::submit_audio()
-{
-	using namespace Audio_out;
 
-	enum {
-		STEREO_PERIOD = Audio_out::PERIOD*2,
-		STEREO_CHUNK = STEREO_PERIOD * Audio_out::SAMPLE_SIZE
-	};
+		_config_rom.node().with_optional_sub_node("report", [&] (Node const &node) {
+			if (node.attribute_value("stats", false))
+				_stats_reporter.construct(_env, "stats", "stats"); });
 
-	while (_pcm.read_avail() >= STEREO_CHUNK) {
+		if (!_format.valid()) {
+			error("unsupported client format");
+			throw Exception();
+		}
 
-		Audio_out::Packet *p[NUM_CHANNELS];
+		if (_format.encoding != Format::F32 || _format.channels != NUM_CHANNELS
+		 || _format.rate != Audio_out::SAMPLE_RATE)
+			_converter.construct(_format, (unsigned)Audio_out::SAMPLE_RATE);
 
-		while (true) {
-			try { p[LEFT] = _out[LEFT]->stream()->alloc(); break; }
-			catch (Audio_out::Stream::Alloc_failed) {
-				_out[LEFT]->wait_for_alloc(); }
-		}
+		log("latency bounded to ", _max_queued + 1, " periods");
+		_report_stats(true);
+	}
+};
 
-		unsigned const ppos = _out[LEFT]->stream()->packet_position(p[LEFT]);
-		p[RIGHT] = _out[RIGHT]->stream()->get(ppos);
 
-		auto *content = (float const *)_pcm.read_addr();
+void Raw_audio::Sink::submit_audio()
+{
+	if (!_started)
+		return;
 
-		/* copy channel contents into sessions */
-		for (unsigned i = 0; i < STEREO_PERIOD; i += NUM_CHANNELS) {
-			for_each_channel([&] (int const c) {
-				p[c]->content()[i/NUM_CHANNELS] = content[i+c]; });
-		}
+	_drain_ring();
 
-		for_each_channel([&] (int const c) {
-			 _out[c]->submit(p[c]); });
-		_pcm.drain(STEREO_CHUNK);
+	if (!_out[LEFT]->stream()->empty()) {
+		_report_stats();
+		return;
 	}
 
-	if (_pcm.read_avail() < Audio_out::SAMPLE_SIZE)
-		for_each_channel([&] (int const c) {
-			 _out[c]->stop(); });
+	/* the queue ran dry, which includes the end of a stream */
+	++_underruns;
+	_stats_changed = true;
+	_report_stats();
+	_stop();
 }
 
 
@@ -182,10 +390,8 @@ class Raw_audio::Terminal_component :
 			/* sanitize argument */
 			num_bytes = Genode::min(num_bytes, _io_buffer.size());
 
-			/* copy to sink */
-			_sink.process(_io_buffer.local_addr<char>(), num_bytes);
-
-			return num_bytes;
+			/* copy to sink, the client retries with the remainder */
+			return _sink.process(_io_buffer.local_addr<char>(), num_bytes);
 		}
 
 		void connected_sigh(Genode::Signal_context_capability cap) override {
@@ -0,0 +1,376 @@
+/*
+ * \brief  Sample-format and rate conversion
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _CONVERT_H_
+#define _CONVERT_H_
+
+/* Genode includes */
+#include <util/string.h>
+#include <util/reconstructible.h>
+
+namespace Raw_audio {
+
+	using namespace Genode;
+
+	struct Format;
+	class Resampler;
+	class Converter;
+}
+
+
+/**
+ * Layout of the samples written by the client
+ */
+struct Raw_audio::Format
+{
+	enum Encoding { S16, S24, S32, F32, INVALID };
+
+	typedef String<8> Name;
+
+	Encoding encoding = F32;
+	unsigned channels = 2;
+	unsigned rate     = 0;
+
+	static Encoding encoding_of(Name const &name)
+	{
+		if (name == "s16") return S16;
+		if (name == "s24") return S24;
+		if (name == "s32") return S32;
+		if (name == "f32") return F32;
+		return INVALID;
+	}
+
+	size_t sample_size() const
+	{
+		switch (encoding) {
+		case S16: return 2;
+		case S24: return 3;
+		case S32: return 4;
+		case F32: return 4;
+		case INVALID: break;
+		}
+		return 0;
+	}
+
+	size_t frame_size() const { return sample_size()*channels; }
+
+	bool valid() const {
+		return encoding != INVALID && (channels == 1 || channels == 2) && rate; }
+
+	/**
+	 * Decode one little-endian sample to float
+	 */
+	float sample(unsigned char const *p) const
+	{
+		switch (encoding) {
+		case S16:
+			return float(int16_t(p[0] | (p[1] << 8))) * (1.0f/32768.0f);
+		case S24:
+			return float(int32_t((p[0] << 8) | (p[1] << 16) | (p[2] << 24)))
+			       * (1.0f/2147483648.0f);
+		case S32:
+			return float(int32_t(p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24)))
+			       * (1.0f/2147483648.0f);
+		case F32:
+			{
+				float f;
+				memcpy(&f, p, sizeof(f));
+				return f;
+			}
+		case INVALID: break;
+		}
+		return 0;
+	}
+};
+
+
+/**
+ * Polyphase windowed-sinc resampler for stereo frames
+ *
+ * The ratio of output to input rate is reduced to 'L/M'. For each of the
+ * 'L' phases, a set of 'TAPS' coefficients of a Blackman-windowed sinc is
+ * precomputed. If 'L' exceeds 'MAX_PHASES', the nearest of 'MAX_PHASES'
+ * evenly spaced phases is used.
+ */
+class Raw_audio::Resampler
+{
+	public:
+
+		enum { TAPS = 16, MAX_PHASES = 256, FIFO_FRAMES = 1024 };
+
+	private:
+
+		typedef float Vec __attribute__((vector_size(16)));
+
+		/* vector access at sample alignment */
+		typedef float Unaligned_vec
+			__attribute__((vector_size(16), aligned(4), may_alias));
+
+		unsigned const _l;
+		unsigned const _m;
+		unsigned const _phases = min(_l, (unsigned)MAX_PHASES);
+
+		Vec _coeff[MAX_PHASES][TAPS/4];
+
+		/* planar input history */
+		float _fifo[2][FIFO_FRAMES];
+
+		unsigned _fifo_frames = 0;
+
+		/* position of the next output within the fifo in units of 1/L */
+		unsigned _index = 0;
+		unsigned _phase = 0;
+
+		static unsigned _gcd(unsigned a, unsigned b)
+		{
+			while (b) { unsigned const t = a % b; a = b; b = t; }
+			return a;
+		}
+
+		static double _sin(double x)
+		{
+			double const PI = 3.14159265358979323846;
+
+			/* reduce to [-pi, pi] */
+			while (x >  PI) x -= 2*PI;
+			while (x < -PI) x += 2*PI;
+
+			/* reduce to [-pi/2, pi/2] */
+			if (x >  PI/2) x =  PI - x;
+			if (x < -PI/2) x = -PI - x;
+
+			double const x2 = x*x;
+			return x*(1 - x2/6*(1 - x2/20*(1 - x2/42*(1 - x2/72*(1 - x2/110)))));
+		}
+
+		static double _cos(double x) { return _sin(x + 3.14159265358979323846/2); }
+
+		void _init_coefficients()
+		{
+			double const PI = 3.14159265358979323846;
+
+			/* cut off below the lower of both Nyquist frequencies */
+			double const fc = 0.95*min(1.0, double(_l)/double(_m));
+
+			for (unsigned p = 0; p < _phases; ++p) {
+				float h[TAPS];
+				double sum = 0;
+
+				double const frac = double(p)/double(_phases);
+				for (unsigned t = 0; t < TAPS; ++t) {
+					double const d = double(t) - (TAPS/2 - 1) - frac;
+					double const x = PI*fc*d;
+					double const sinc = (d == 0) ? 1.0 : _sin(x)/x;
+					double const w = 0.42 + 0.5*_cos(PI*d/(TAPS/2))
+					                      + 0.08*_cos(2*PI*d/(TAPS/2));
+					h[t] = float(fc*sinc*w);
+					sum += h[t];
+				}
+
+				/* unity gain for each phase */
+				for (unsigned t = 0; t < TAPS; ++t)
+					h[t] = float(h[t]/sum);
+
+				memcpy(_coeff[p], h, sizeof(h));
+			}
+		}
+
+		static float _dot(Vec const *coeff, float const *src)
+		{
+			Vec acc { };
+			for (unsigned i = 0; i < TAPS/4; ++i)
+				acc += coeff[i] * *(Unaligned_vec const *)&src[i*4];
+			return acc[0] + acc[1] + acc[2] + acc[3];
+		}
+
+	public:
+
+		Resampler(unsigned in_rate, unsigned out_rate)
+		:
+			_l(out_rate / _gcd(in_rate, out_rate)),
+			_m(in_rate  / _gcd(in_rate, out_rate))
+		{
+			_init_coefficients();
+
+			memset(_fifo, 0, sizeof(_fifo));
+
+			/* start with a delay of half the filter length */
+			_fifo_frames = TAPS/2 - 1;
+		}
+
+		/**
+		 * Number of frames that may be pushed
+		 */
+		unsigned push_avail()
+		{
+			if (_fifo_frames == FIFO_FRAMES && _index) {
+				/* drop the frames preceding the filter window */
+				unsigned const drop = min(_index, _fifo_frames);
+				unsigned const keep = _fifo_frames - drop;
+				for (unsigned c = 0; c < 2; ++c)
+					memmove(_fifo[c], &_fifo[c][drop], keep*sizeof(float));
+				_fifo_frames = keep;
+				_index -= drop;
+			}
+			return FIFO_FRAMES - _fifo_frames;
+		}
+
+		void push(float left, float right)
+		{
+			_fifo[0][_fifo_frames] = left;
+			_fifo[1][_fifo_frames] = right;
+			++_fifo_frames;
+		}
+
+		/**
+		 * Produce interleaved output frames from the pushed input
+		 *
+		 * \return number of frames written to 'dst'
+		 */
+		size_t pull(float *dst, size_t max_frames)
+		{
+			size_t n = 0;
+			while (n < max_frames && _index + TAPS <= _fifo_frames) {
+
+				unsigned const p = unsigned((uint64_t(_phase)*_phases) / _l);
+
+				dst[n*2]     = _dot(_coeff[p], &_fifo[0][_index]);
+				dst[n*2 + 1] = _dot(_coeff[p], &_fifo[1][_index]);
+				++n;
+
+				_phase += _m;
+				_index += _phase / _l;
+				_phase %= _l;
+			}
+			return n;
+		}
+};
+
+
+/**
+ * Conversion of client frames to float stereo at the Audio_out rate
+ */
+class Raw_audio::Converter
+{
+	public:
+
+		struct Result { size_t consumed; size_t produced; };
+
+	private:
+
+		Format const _format;
+
+		Constructible<Resampler> _resampler { };
+
+		/* bytes of a frame that was split across writes */
+		unsigned char _partial[16] { };
+		size_t        _partial_size = 0;
+
+		void _decode(unsigned char const *frame, float &left, float &right)
+		{
+			left = _format.sample(frame);
+			right = (_format.channels == 2)
+			      ? _format.sample(frame + _format.sample_size()) : left;
+		}
+
+		/**
+		 * Convert one frame, return false if there is no room for output
+		 */
+		bool _convert_frame(unsigned char const *frame, float *dst,
+		                    size_t max_frames, size_t &produced)
+		{
+			float left, right;
+
+			if (!_resampler.constructed()) {
+				if (produced == max_frames)
+					return false;
+				_decode(frame, left, right);
+				dst[produced*2]     = left;
+				dst[produced*2 + 1] = right;
+				++produced;
+				return true;
+			}
+
+			produced += _resampler->pull(&dst[produced*2], max_frames - produced);
+			if (!_resampler->push_avail())
+				return false;
+
+			_decode(frame, left, right);
+			_resampler->push(left, right);
+			return true;
+		}
+
+	public:
+
+		Converter(Format const &format, unsigned out_rate)
+		: _format(format)
+		{
+			if (format.rate != out_rate)
+				_resampler.construct(format.rate, out_rate);
+		}
+
+		/**
+		 * Convert client data to interleaved float stereo
+		 *
+		 * Partial frames are retained until the next call.
+		 *
+		 * \param dst         destination of the converted frames
+		 * \param max_frames  number of frames that fit into 'dst'
+		 */
+		Result convert(char const *src, size_t num_bytes,
+		               float *dst, size_t max_frames)
+		{
+			unsigned char const *bytes = (unsigned char const *)src;
+			size_t const frame_size = _format.frame_size();
+
+			Result result { 0, 0 };
+
+			/* complete a frame from the previous write */
+			if (_partial_size) {
+				size_t const n = min(frame_size - _partial_size, num_bytes);
+				memcpy(&_partial[_partial_size], bytes, n);
+				if (_partial_size + n < frame_size) {
+					_partial_size += n;
+					result.consumed = n;
+					return result;
+				}
+				if (!_convert_frame(_partial, dst, max_frames, result.produced))
+					return result;
+				_partial_size = 0;
+				result.consumed = n;
+			}
+
+			while (result.consumed + frame_size <= num_bytes) {
+				if (!_convert_frame(&bytes[result.consumed], dst, max_frames,
+				                    result.produced))
+					break;
+				result.consumed += frame_size;
+			}
+
+			/* retain the trailing bytes of an incomplete frame */
+			if (result.consumed + frame_size > num_bytes
+			 && result.consumed < num_bytes) {
+				_partial_size = num_bytes - result.consumed;
+				memcpy(_partial, &bytes[result.consumed], _partial_size);
+				result.consumed = num_bytes;
+			}
+
+			/* drain the resampler as far as the destination permits */
+			if (_resampler.constructed())
+				result.produced += _resampler->pull(&dst[result.produced*2],
+				                                    max_frames - result.produced);
+			return result;
+		}
+};
+
+#endif
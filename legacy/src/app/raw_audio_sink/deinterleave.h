@@ -0,0 +1,64 @@
+/*
+ * \brief  Stereo deinterleave kernel
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _DEINTERLEAVE_H_
+#define _DEINTERLEAVE_H_
+
+/* Genode includes */
+#include <base/stdint.h>
+
+namespace Raw_audio {
+
+	/**
+	 * Split interleaved stereo samples into a left and right channel
+	 *
+	 * Four frames are processed per iteration using the GCC vector
+	 * extension, which is lowered to SSE on x86 and to NEON on ARM.
+	 * The buffers need only be aligned to the sample size.
+	 *
+	 * \param src     interleaved samples, two per frame
+	 * \param left    destination of the left channel
+	 * \param right   destination of the right channel
+	 * \param frames  number of frames
+	 */
+	static inline void deinterleave_stereo(float const *src,
+	                                       float *left, float *right,
+	                                       Genode::size_t frames)
+	{
+		typedef float Vec  __attribute__((vector_size(16)));
+		typedef int   Mask __attribute__((vector_size(16)));
+
+		/* vector access at sample alignment */
+		typedef float Unaligned_vec
+			__attribute__((vector_size(16), aligned(4), may_alias));
+
+		Mask const even { 0, 2, 4, 6 };
+		Mask const odd  { 1, 3, 5, 7 };
+
+		Genode::size_t i = 0;
+		for (; i + 4 <= frames; i += 4) {
+			Vec const lo = *(Unaligned_vec const *)&src[i*2];
+			Vec const hi = *(Unaligned_vec const *)&src[i*2 + 4];
+
+			*(Unaligned_vec *)&left[i]  = __builtin_shuffle(lo, hi, even);
+			*(Unaligned_vec *)&right[i] = __builtin_shuffle(lo, hi, odd);
+		}
+
+		for (; i < frames; ++i) {
+			left[i]  = src[i*2];
+			right[i] = src[i*2 + 1];
+		}
+	}
+}
+
+#endif
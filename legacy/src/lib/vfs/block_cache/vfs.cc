@@ -0,0 +1,700 @@
+/*
+ * \brief  Page cache for a block-device file
+ * \author Genode Labs
+ * \date   2026-10-19
+ *
+ * The plugin provides a single file that caches the content of another
+ * file of the VFS, usually the file of a '<block>' plugin. Reads are
+ * served from a pool of pages, sequential reads are detected per handle
+ * and fetched with a readahead window that grows up to a configurable
+ * size. Writes to cached pages are kept in the cache and written back in
+ * runs of adjacent pages on sync or when too many pages are dirty.
+ *
+ * The FUSE file systems access their device with many small requests of
+ * the size of a file-system block, which the cache turns into fewer
+ * requests of the size of a readahead window.
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#include <vfs/env.h>
+#include <vfs/file_system_factory.h>
+#include <vfs/single_file_system.h>
+#include <base/attached_ram_dataspace.h>
+#include <util/misc_math.h>
+#include <util/string.h>
+
+namespace Vfs_block_cache {
+
+	using namespace Genode;
+	using namespace Genode::Vfs;
+
+	class File_system;
+}
+
+
+class Vfs_block_cache::File_system : public Single_file_system
+{
+	private:
+
+		enum { MAX_PAGES = 16384, NONE = ~0U };
+
+		struct Page
+		{
+			uint64_t no         = 0;
+			unsigned next       = NONE;  /* hash chain */
+			bool     used       = false;
+			bool     dirty      = false;
+			bool     referenced = false;
+		};
+
+		/**
+		 * Sequential-access state of a handle
+		 */
+		struct Readahead
+		{
+			uint64_t next_offset = 0;
+			unsigned window      = 1;  /* pages */
+		};
+
+		struct Handle : Single_vfs_handle
+		{
+			File_system &_cache;
+
+			Readahead _readahead { };
+
+			Handle(Directory_service &ds, File_io_service &fs,
+			       Allocator &alloc, File_system &cache)
+			:
+				Single_vfs_handle(ds, fs, alloc, 0), _cache(cache)
+			{ }
+
+			Read_result read(Byte_range_ptr const &dst, size_t &out_count) override {
+				return _cache._read(seek(), dst, out_count, _readahead); }
+
+			Write_result write(Const_byte_range_ptr const &src, size_t &out_count) override {
+				return _cache._write(seek(), src, out_count); }
+
+			bool read_ready()  const override { return true; }
+			bool write_ready() const override { return true; }
+		};
+
+		using Path = String<MAX_PATH_LEN>;
+
+		Vfs::Env &_env;
+
+		Path const _file;
+
+		size_t   const _page_size;
+		unsigned const _num_pages;
+		unsigned const _max_readahead;  /* pages */
+		unsigned const _dirty_limit;    /* pages */
+
+		Attached_ram_dataspace _pages_ds;
+		Attached_ram_dataspace _staging_ds;
+
+		Page     _pages[MAX_PAGES]  { };
+		unsigned _hash[MAX_PAGES]   { };
+		unsigned _sorted[MAX_PAGES] { };
+
+		unsigned _clock_hand = 0;
+		unsigned _dirty      = 0;
+
+		Vfs_handle *_inner = nullptr;
+		file_size   _size  = 0;
+
+		/*
+		 * Read of the inner file into the staging buffer, either pages
+		 * to be cached or a request that bypasses the cache
+		 */
+		struct Inner_read
+		{
+			bool     queued = false;
+			bool     fill   = false;
+			uint64_t offset = 0;
+			size_t   length = 0;
+		} _inner_read { };
+
+		bool _sync_queued = false;
+		bool _write_error = false;
+
+		static size_t _page_size_from_config(Node const &config)
+		{
+			size_t const size = config.attribute_value("page_size", Number_of_bytes(4096));
+			if (size < 512 || (size & (size - 1))) {
+				warning("invalid page_size ", size, ", using 4096");
+				return 4096;
+			}
+			return size;
+		}
+
+		static unsigned _num_pages_from_config(Node const &config, size_t page_size)
+		{
+			size_t const cache_size =
+				config.attribute_value("cache_size", Number_of_bytes(8*1024*1024));
+
+			return unsigned(max(size_t(16), min(cache_size / page_size, size_t(MAX_PAGES))));
+		}
+
+		char *_data(unsigned index) {
+			return _pages_ds.local_addr<char>() + index*_page_size; }
+
+		char *_staging() { return _staging_ds.local_addr<char>(); }
+
+		size_t _staging_size() const { return _max_readahead*_page_size; }
+
+		unsigned _slot(uint64_t no) const { return unsigned(no % _num_pages); }
+
+		unsigned _lookup(uint64_t no) const
+		{
+			for (unsigned i = _hash[_slot(no)]; i != NONE; i = _pages[i].next)
+				if (_pages[i].no == no)
+					return i;
+			return NONE;
+		}
+
+		void _link(unsigned index, uint64_t no)
+		{
+			Page &page = _pages[index];
+			page.no   = no;
+			page.used = true;
+			page.next = _hash[_slot(no)];
+			_hash[_slot(no)] = index;
+		}
+
+		void _unlink(unsigned index)
+		{
+			unsigned *link = &_hash[_slot(_pages[index].no)];
+			while (*link != index)
+				link = &_pages[*link].next;
+			*link = _pages[index].next;
+			_pages[index].used = false;
+		}
+
+		/**
+		 * Select a clean page for reuse
+		 *
+		 * Pages are evicted in approximate LRU order by the clock
+		 * algorithm, a page that was accessed since the hand passed it
+		 * last gets another round.
+		 *
+		 * \return page index or NONE if all pages are dirty
+		 */
+		unsigned _victim()
+		{
+			for (unsigned n = 0; n < 2*_num_pages; ++n) {
+				unsigned const i = _clock_hand;
+				_clock_hand = (_clock_hand + 1) % _num_pages;
+
+				Page &page = _pages[i];
+				if (!page.used)
+					return i;
+				if (page.dirty)
+					continue;
+				if (page.referenced) {
+					page.referenced = false;
+					continue;
+				}
+				return i;
+			}
+			return NONE;
+		}
+
+		unsigned _alloc_page(uint64_t no)
+		{
+			unsigned const i = _victim();
+			if (i == NONE)
+				return NONE;
+
+			if (_pages[i].used)
+				_unlink(i);
+
+			_pages[i].dirty      = false;
+			_pages[i].referenced = true;
+			_link(i, no);
+			return i;
+		}
+
+		void _mark_dirty(unsigned index)
+		{
+			if (!_pages[index].dirty)
+				++_dirty;
+			_pages[index].dirty      = true;
+			_pages[index].referenced = true;
+		}
+
+		bool _inner_open()
+		{
+			if (_inner)
+				return true;
+
+			Directory_service::Stat stat { };
+			if (_env.root_dir().stat(_file.string(), stat) != STAT_OK) {
+				error("block_cache: cannot stat '", _file, "'");
+				return false;
+			}
+
+			Vfs_handle *handle = nullptr;
+			if (_env.root_dir().open(_file.string(), Directory_service::OPEN_MODE_RDWR,
+			                         &handle, _env.alloc()) != Directory_service::OPEN_OK
+			 && _env.root_dir().open(_file.string(), Directory_service::OPEN_MODE_RDONLY,
+			                         &handle, _env.alloc()) != Directory_service::OPEN_OK) {
+				error("block_cache: cannot open '", _file, "'");
+				return false;
+			}
+
+			_inner = handle;
+			_size  = stat.size;
+			return true;
+		}
+
+		/**
+		 * Read from the inner file into the staging buffer or 'dst'
+		 *
+		 * The read is queued on the first call and collected by a later
+		 * call with the same arguments.
+		 */
+		Read_result _read_inner(uint64_t offset, Byte_range_ptr const &dst,
+		                        bool fill, size_t &out_count)
+		{
+			if (!_inner_read.queued) {
+				_inner->seek(offset);
+				if (!_inner->fs().queue_read(_inner, dst.num_bytes))
+					return READ_QUEUED;
+				_inner_read = { true, fill, offset, dst.num_bytes };
+			}
+
+			_inner->seek(_inner_read.offset);
+			Read_result const result =
+				_inner->fs().complete_read(_inner, dst, out_count);
+
+			if (result != READ_QUEUED)
+				_inner_read.queued = false;
+
+			return result;
+		}
+
+		/**
+		 * Store pages read into the staging buffer in the cache
+		 */
+		void _insert_staged(size_t length)
+		{
+			uint64_t const first = _inner_read.offset / _page_size;
+
+			/* a partial page at the end of the device is padded */
+			unsigned const count = unsigned(align_addr(length, log2(_page_size)) / _page_size);
+			if (length % _page_size)
+				memset(_staging() + length, 0, _page_size - length % _page_size);
+
+			for (unsigned i = 0; i < count; ++i) {
+
+				/* a dirty page is newer than the device content */
+				if (_lookup(first + i) != NONE)
+					continue;
+
+				unsigned const index = _alloc_page(first + i);
+				if (index == NONE)
+					return;
+
+				memcpy(_data(index), _staging() + i*_page_size, _page_size);
+			}
+		}
+
+		/**
+		 * Collect a pending fill of the cache
+		 *
+		 * \return false if the fill is still in progress
+		 */
+		bool _complete_fill()
+		{
+			if (!_inner_read.queued || !_inner_read.fill)
+				return true;
+
+			size_t out_count = 0;
+			Read_result const result = _read_inner(_inner_read.offset,
+				Byte_range_ptr(_staging(), _inner_read.length), true, out_count);
+
+			if (result == READ_QUEUED)
+				return false;
+
+			if (result == READ_OK)
+				_insert_staged(out_count);
+
+			return true;
+		}
+
+		/**
+		 * Read pages starting at page 'no' into the cache
+		 *
+		 * The fill stops at the first page that is cached already.
+		 */
+		Read_result _fill(uint64_t no, unsigned window)
+		{
+			if (_inner_read.queued) {
+				if (!_inner_read.fill || !_complete_fill())
+					return READ_QUEUED;
+
+				/* the collected fill may have brought the page already */
+				if (_lookup(no) != NONE)
+					return READ_OK;
+			}
+
+			uint64_t const offset = no*_page_size;
+
+			size_t length = min(size_t(window)*_page_size, _staging_size());
+			if (offset + length > _size)
+				length = size_t(_size - offset);
+
+			for (size_t o = _page_size; o < length; o += _page_size)
+				if (_lookup(no + o/_page_size) != NONE) {
+					length = o;
+					break;
+				}
+
+			size_t out_count = 0;
+			Read_result const result = _read_inner(offset,
+				Byte_range_ptr(_staging(), length), true, out_count);
+
+			if (result != READ_OK)
+				return result;
+
+			if (out_count == 0)
+				return READ_ERR_IO;
+
+			_insert_staged(out_count);
+			return READ_OK;
+		}
+
+		/**
+		 * Write runs of adjacent dirty pages to the inner file
+		 *
+		 * \return false if not all pages could be written yet
+		 */
+		bool _flush()
+		{
+			if (_dirty == 0)
+				return true;
+
+			/* the inner handle is used by one request at a time */
+			if (_inner_read.queued && (!_inner_read.fill || !_complete_fill()))
+				return false;
+
+			unsigned count = 0;
+			for (unsigned i = 0; i < _num_pages; ++i)
+				if (_pages[i].used && _pages[i].dirty)
+					_sorted[count++] = i;
+
+			/* shell sort by page number */
+			for (unsigned gap = count/2; gap > 0; gap /= 2)
+				for (unsigned i = gap; i < count; ++i) {
+					unsigned const index = _sorted[i];
+					unsigned j = i;
+					for (; j >= gap && _pages[_sorted[j - gap]].no > _pages[index].no; j -= gap)
+						_sorted[j] = _sorted[j - gap];
+					_sorted[j] = index;
+				}
+
+			for (unsigned first = 0; first < count; ) {
+
+				unsigned last = first;
+				while (last + 1 < count
+				    && last + 1 - first < _max_readahead
+				    && _pages[_sorted[last + 1]].no == _pages[_sorted[last]].no + 1)
+					++last;
+
+				unsigned const run    = last - first + 1;
+				uint64_t const offset = _pages[_sorted[first]].no*_page_size;
+
+				size_t length = run*_page_size;
+				if (offset + length > _size)
+					length = size_t(_size - offset);
+
+				for (unsigned i = 0; i < run; ++i)
+					memcpy(_staging() + i*_page_size, _data(_sorted[first + i]), _page_size);
+
+				size_t out_count = 0;
+				_inner->seek(offset);
+				Write_result const result = _inner->fs().write(_inner,
+					Const_byte_range_ptr(_staging(), length), out_count);
+
+				if (result == WRITE_ERR_WOULD_BLOCK)
+					return false;
+
+				if (result != WRITE_OK) {
+					error("block_cache: write-back at offset ", offset, " failed");
+					_write_error = true;
+					out_count    = length;
+				}
+
+				unsigned const written = (out_count == length)
+				                       ? run : unsigned(out_count / _page_size);
+
+				for (unsigned i = 0; i < written; ++i) {
+					_pages[_sorted[first + i]].dirty = false;
+					--_dirty;
+				}
+
+				if (written < run)
+					return false;
+
+				first = last + 1;
+			}
+			return true;
+		}
+
+		Read_result _read(uint64_t offset, Byte_range_ptr const &dst,
+		                  size_t &out_count, Readahead &readahead)
+		{
+			out_count = 0;
+
+			if (!_inner_open())
+				return READ_ERR_IO;
+
+			if (offset >= _size)
+				return READ_OK;
+
+			size_t const length = size_t(min(uint64_t(dst.num_bytes), _size - offset));
+
+			/*
+			 * Large requests are read directly, they would evict the pages
+			 * of the request itself from a small cache
+			 */
+			if (length > _staging_size()) {
+				if (!_flush())
+					return READ_QUEUED;
+				if (_inner_read.queued && (_inner_read.fill
+				 || _inner_read.offset != offset))
+					return READ_QUEUED;
+				return _read_inner(offset, Byte_range_ptr(dst.start, length),
+				                   false, out_count);
+			}
+
+			/* grow the readahead window while the handle reads sequentially */
+			bool const sequential = (offset == readahead.next_offset);
+
+			/*
+			 * Pages copied before a fill is queued are copied again on
+			 * the retry, so the request is served as a whole.
+			 */
+			size_t copied = 0;
+			while (copied < length) {
+
+				uint64_t const pos  = offset + copied;
+				uint64_t const no   = pos / _page_size;
+				size_t   const skip = size_t(pos % _page_size);
+
+				unsigned index = _lookup(no);
+				if (index == NONE) {
+
+					unsigned const needed =
+						unsigned((skip + length - copied + _page_size - 1) / _page_size);
+
+					unsigned const window = sequential
+						? max(readahead.window, needed) : needed;
+
+					Read_result const result = _fill(no, window);
+					if (result != READ_OK)
+						return result;
+
+					index = _lookup(no);
+					if (index == NONE)
+						return READ_ERR_IO;
+				}
+
+				size_t const n = min(length - copied, _page_size - skip);
+				memcpy(dst.start + copied, _data(index) + skip, n);
+				_pages[index].referenced = true;
+				copied += n;
+			}
+
+			readahead.window      = sequential ? min(readahead.window*2, _max_readahead) : 1;
+			readahead.next_offset = offset + length;
+
+			out_count = length;
+			return READ_OK;
+		}
+
+		Write_result _write(uint64_t offset, Const_byte_range_ptr const &src,
+		                    size_t &out_count)
+		{
+			out_count = 0;
+
+			if (!_inner_open())
+				return WRITE_ERR_IO;
+
+			if (offset >= _size)
+				return WRITE_ERR_INVALID;
+
+			size_t const length = size_t(min(uint64_t(src.num_bytes), _size - offset));
+
+			/* keep enough clean pages for reads and readahead */
+			if (_dirty >= _dirty_limit && !_flush())
+				return WRITE_ERR_WOULD_BLOCK;
+
+			/* pages updated before blocking are updated again on the retry */
+			size_t copied = 0;
+			while (copied < length) {
+
+				uint64_t const pos  = offset + copied;
+				uint64_t const no   = pos / _page_size;
+				size_t   const skip = size_t(pos % _page_size);
+				size_t   const n    = min(length - copied, _page_size - skip);
+
+				unsigned index = _lookup(no);
+
+				if (index == NONE && n == _page_size)
+					index = _alloc_page(no);
+
+				/* a partially written page is read first */
+				if (index == NONE) {
+					Read_result const result = _fill(no, 1);
+					if (result == READ_QUEUED)
+						return WRITE_ERR_WOULD_BLOCK;
+					if (result != READ_OK)
+						return WRITE_ERR_IO;
+
+					index = _lookup(no);
+					if (index == NONE)
+						return WRITE_ERR_WOULD_BLOCK;
+				}
+
+				memcpy(_data(index) + skip, src.start + copied, n);
+				_mark_dirty(index);
+				copied += n;
+
+				if (_dirty >= _dirty_limit && !_flush())
+					return WRITE_ERR_WOULD_BLOCK;
+			}
+
+			out_count = length;
+			return WRITE_OK;
+		}
+
+	public:
+
+		File_system(Vfs::Env &env, Node const &config)
+		:
+			Single_file_system(Node_type::CONTINUOUS_FILE, type_name(),
+			                   Node_rwx::rw(), config),
+			_env(env),
+			_file(config.attribute_value("file", Path())),
+			_page_size(_page_size_from_config(config)),
+			_num_pages(_num_pages_from_config(config, _page_size)),
+			_max_readahead(unsigned(max(size_t(1), min(size_t(_num_pages/4),
+				config.attribute_value("readahead", Number_of_bytes(256*1024)) / _page_size)))),
+			_dirty_limit(_num_pages/2),
+			_pages_ds(env.env().ram(), env.env().rm(), _num_pages*_page_size),
+			_staging_ds(env.env().ram(), env.env().rm(), _max_readahead*_page_size)
+		{
+			for (unsigned i = 0; i < MAX_PAGES; ++i)
+				_hash[i] = NONE;
+
+			if (!_file.valid())
+				error("block_cache: missing 'file' attribute");
+		}
+
+		~File_system()
+		{
+			if (!_inner)
+				return;
+
+			if (!_flush())
+				warning("block_cache: ", _dirty, " dirty pages not written back");
+
+			_inner->ds().close(_inner);
+		}
+
+		static char const *type_name() { return "block_cache"; }
+
+		char const *type() override { return type_name(); }
+
+
+		/*********************************
+		 ** Directory service interface **
+		 *********************************/
+
+		Stat_result stat(char const *path, Stat &out) override
+		{
+			Stat_result const result = Single_file_system::stat(path, out);
+			if (result == STAT_OK && _inner_open())
+				out.size = _size;
+			return result;
+		}
+
+		Open_result open(char const  *path, unsigned,
+		                 Vfs_handle **out_handle,
+		                 Allocator   &alloc) override
+		{
+			if (!_single_file(path))
+				return OPEN_ERR_UNACCESSIBLE;
+
+			try {
+				*out_handle = new (alloc) Handle(*this, *this, alloc, *this);
+				return OPEN_OK;
+			}
+			catch (Out_of_ram)  { return OPEN_ERR_OUT_OF_RAM; }
+			catch (Out_of_caps) { return OPEN_ERR_OUT_OF_CAPS; }
+		}
+
+
+		/********************************
+		 ** File I/O service interface **
+		 ********************************/
+
+		Ftruncate_result ftruncate(Vfs_handle *, file_size) override {
+			return FTRUNCATE_OK; }
+
+		/*
+		 * A sync writes back all dirty pages and then syncs the inner
+		 * file, which is the point at which a file system expects its
+		 * data to be on the device.
+		 */
+		Sync_result complete_sync(Vfs_handle *) override
+		{
+			if (!_inner)
+				return SYNC_OK;
+
+			if (!_flush())
+				return SYNC_QUEUED;
+
+			if (!_sync_queued) {
+				if (!_inner->fs().queue_sync(_inner))
+					return SYNC_QUEUED;
+				_sync_queued = true;
+			}
+
+			Sync_result const result = _inner->fs().complete_sync(_inner);
+			if (result == SYNC_QUEUED)
+				return result;
+
+			_sync_queued = false;
+
+			if (_write_error) {
+				_write_error = false;
+				return SYNC_ERR_INVALID;
+			}
+			return result;
+		}
+};
+
+
+extern "C" Genode::Vfs::File_system_factory *vfs_file_system_factory(void)
+{
+	using namespace Genode;
+
+	struct Factory : Vfs::File_system_factory
+	{
+		Vfs::File_system *create(Vfs::Env &vfs_env, Node const &config) override
+		{
+			return new (vfs_env.alloc()) Vfs_block_cache::File_system(vfs_env, config);
+		}
+	};
+
+	static Factory f;
+	return &f;
+}
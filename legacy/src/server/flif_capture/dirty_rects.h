@@ -0,0 +1,79 @@
+/*
+ * \brief  Accumulation of refreshed framebuffer regions
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _FLIF_CAPTURE__DIRTY_RECTS_H_
+#define _FLIF_CAPTURE__DIRTY_RECTS_H_
+
+/* local includes */
+#include <encoder_pool.h>
+
+namespace Flif_capture { class Dirty_rects; }
+
+
+/**
+ * Set of disjoint regions that changed since the last capture
+ *
+ * Overlapping regions are merged into their bounding box. If the set is
+ * full, all regions are merged into one.
+ */
+class Flif_capture::Dirty_rects
+{
+	private:
+
+		Rect     _rects[MAX_RECTS] { };
+		unsigned _count = 0;
+
+		static bool _overlap(Rect const &a, Rect const &b)
+		{
+			return a.x1() <= b.x2() && b.x1() <= a.x2()
+			    && a.y1() <= b.y2() && b.y1() <= a.y2();
+		}
+
+		void _remove(unsigned i) { _rects[i] = _rects[--_count]; }
+
+	public:
+
+		void add(Rect rect)
+		{
+			if (!rect.valid())
+				return;
+
+			/* absorb every region that overlaps the growing rectangle */
+			for (unsigned i = 0; i < _count; ) {
+				if (_overlap(_rects[i], rect)) {
+					rect = Rect::compound(_rects[i], rect);
+					_remove(i);
+					i = 0;
+				} else
+					++i;
+			}
+
+			if (_count == MAX_RECTS) {
+				for (unsigned i = 0; i < _count; ++i)
+					rect = Rect::compound(_rects[i], rect);
+				_count = 0;
+			}
+
+			_rects[_count++] = rect;
+		}
+
+		void clear() { _count = 0; }
+
+		bool empty() const { return _count == 0; }
+
+		Rect const *rects() const { return _rects; }
+
+		unsigned count() const { return _count; }
+};
+
+#endif /* _FLIF_CAPTURE__DIRTY_RECTS_H_ */
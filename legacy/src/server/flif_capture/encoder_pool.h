@@ -0,0 +1,435 @@
+/*
+ * \brief  Pool of FLIF encoder threads
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _FLIF_CAPTURE__ENCODER_POOL_H_
+#define _FLIF_CAPTURE__ENCODER_POOL_H_
+
+/* FLIF includes */
+#include <flif_enc.h>
+
+/* Genode includes */
+#include <framebuffer_session/framebuffer_session.h>
+#include <base/attached_ram_dataspace.h>
+#include <base/heap.h>
+#include <base/sleep.h>
+#include <util/fifo.h>
+
+/* libc includes */
+#include <pthread.h>
+
+/* local includes */
+#include <swizzle.h>
+
+namespace Flif_capture {
+	using namespace Genode;
+
+	using Area = Framebuffer::Area;
+	using Rect = Framebuffer::Rect;
+
+	enum Kind { SCREENSHOT, FRAME };
+
+	/* regions of a frame that are encoded separately */
+	enum { MAX_RECTS = 16 };
+
+	struct Snapshot;
+	struct Encoded;
+	class Encoder_pool;
+}
+
+
+/**
+ * Copy of framebuffer regions, taken by the service entrypoint
+ *
+ * The pixels of the regions are stored consecutively in the buffer.
+ */
+struct Flif_capture::Snapshot
+{
+	enum State { FREE, BUSY, QUEUED };
+
+	Constructible<Attached_ram_dataspace> buffer { };
+
+	State    state = FREE;
+	Kind     kind  = SCREENSHOT;
+	unsigned seq   = 0;
+	uint64_t time_us = 0;
+
+	Area     screen { };
+	Rect     rects[MAX_RECTS] { };
+	unsigned rect_count = 0;
+};
+
+
+/**
+ * Encoded regions, passed from an encoder to the writer
+ *
+ * Each region is encoded as a separate FLIF image.
+ */
+struct Flif_capture::Encoded : Fifo<Encoded>::Element
+{
+	Kind     const kind;
+	unsigned const seq;
+	uint64_t const time_us;
+	Area     const screen;
+
+	Rect     rects[MAX_RECTS] { };
+	void    *data[MAX_RECTS] { };
+	size_t   size[MAX_RECTS] { };
+	unsigned rect_count = 0;
+
+	Encoded(Snapshot const &snapshot)
+	:
+		kind(snapshot.kind), seq(snapshot.seq),
+		time_us(snapshot.time_us), screen(snapshot.screen)
+	{ }
+
+	~Encoded()
+	{
+		for (unsigned i = 0; i < rect_count; ++i)
+			flif_free_memory(data[i]);
+	}
+};
+
+
+/**
+ * Encoder threads that convert snapshots to FLIF images in memory
+ *
+ * A capture is a copy of the framebuffer regions into a free snapshot
+ * buffer, so the service entrypoint is never held up by encoding. A
+ * capture is refused if all snapshot buffers are in use. There is one
+ * snapshot buffer more than there are encoders so that a capture can be
+ * taken while every encoder is busy. Screenshots and stream frames are
+ * numbered separately.
+ *
+ * The encoders are pthreads because libflif allocates from and calls
+ * into the libc.
+ */
+class Flif_capture::Encoder_pool
+{
+	public:
+
+		enum { MAX_ENCODERS = 8 };
+
+		/* stream frames that are captured but not yet released */
+		enum { MAX_FRAMES_IN_FLIGHT = MAX_ENCODERS*2 };
+
+	private:
+
+		struct Worker
+		{
+			Encoder_pool &_pool;
+
+			pthread_t _thread { };
+
+			/* the image is reused while the region size is stable */
+			FLIF_IMAGE *_image = nullptr;
+			Area        _image_area { };
+
+			static void *_entry(void *arg)
+			{
+				Worker &worker = *(Worker *)arg;
+				worker._pool._work(worker);
+				return nullptr;
+			}
+
+			Worker(Encoder_pool &pool) : _pool(pool) { }
+
+			~Worker() { if (_image) flif_destroy_image(_image); }
+
+			/**
+			 * Convert a region in place and import it into the image
+			 */
+			bool _import(uint8_t *rgba, Area area)
+			{
+				if (!_image || area.w != _image_area.w || area.h != _image_area.h) {
+					if (_image) flif_destroy_image(_image);
+
+					_image      = flif_create_image(area.w, area.h);
+					_image_area = area;
+					if (!_image) return false;
+				}
+
+				xrgb_to_rgba((uint32_t const *)rgba, rgba, area.count());
+
+				for (unsigned y = 0; y < area.h; y++)
+					flif_image_write_row_RGBA8(_image, y, &rgba[y*area.w*4], area.w*4);
+
+				return true;
+			}
+
+			/**
+			 * Encode the imported image
+			 */
+			bool _encode(void *&data, size_t &size)
+			{
+				FLIF_ENCODER *encoder = flif_create_encoder();
+				if (!encoder) {
+					error("failed to create FLIF encoder");
+					return false;
+				}
+				flif_encoder_set_lookback(encoder, 0);
+				flif_encoder_add_image(encoder, _image);
+
+				bool const ok = flif_encoder_encode_memory(encoder, &data, &size);
+				flif_destroy_encoder(encoder);
+				return ok;
+			}
+
+			/**
+			 * Start the thread, must be called in libc context
+			 */
+			bool start()
+			{
+				pthread_attr_t attr;
+				pthread_attr_init(&attr);
+				pthread_attr_setstacksize(&attr, sizeof(addr_t) << 15);
+
+				int const err = pthread_create(&_thread, &attr, _entry, this);
+				pthread_attr_destroy(&attr);
+				return err == 0;
+			}
+		};
+
+		Env &_env;
+
+		Heap _heap { _env.ram(), _env.rm() };
+
+		unsigned const _count;
+
+		Snapshot _snapshots[MAX_ENCODERS + 1];
+
+		/* protects the snapshot states and the encoded queue */
+		Mutex _mutex { };
+
+		Semaphore _queued { };
+
+		Fifo<Encoded> _encoded { };
+		Semaphore     _encoded_avail { };
+
+		unsigned _seq[2] { 0, 0 };
+
+		unsigned _frames_in_flight = 0;
+
+		/* a stream frame lost regions since the last 'frame_failed' */
+		bool _frame_failed = false;
+
+		Constructible<Worker> _workers[MAX_ENCODERS];
+
+		Snapshot *_next_queued()
+		{
+			Mutex::Guard guard(_mutex);
+
+			/* take the oldest snapshot first */
+			Snapshot *next = nullptr;
+			for (unsigned i = 0; i <= _count; ++i) {
+				Snapshot &s = _snapshots[i];
+				if (s.state == Snapshot::QUEUED
+				 && (!next || s.time_us < next->time_us))
+					next = &s;
+			}
+			if (next)
+				next->state = Snapshot::BUSY;
+			return next;
+		}
+
+		void _work(Worker &worker)
+		{
+			for (;;) {
+				_queued.down();
+
+				Snapshot *snapshot = _next_queued();
+				if (!snapshot)
+					continue;
+
+				Encoded &encoded = *new (_heap) Encoded(*snapshot);
+
+				uint8_t *pixels = snapshot->buffer->local_addr<uint8_t>();
+
+				bool ok = true;
+				for (unsigned i = 0; ok && i < snapshot->rect_count; ++i) {
+					Rect const rect = snapshot->rects[i];
+
+					ok = worker._import(pixels, rect.area)
+					  && worker._encode(encoded.data[i], encoded.size[i]);
+					if (ok) {
+						encoded.rects[i] = rect;
+						encoded.rect_count = i + 1;
+					}
+					pixels += rect.area.count()*sizeof(uint32_t);
+				}
+
+				{
+					Mutex::Guard guard(_mutex);
+					snapshot->state = Snapshot::FREE;
+				}
+
+				/* a failed frame is passed on to keep the stream in sequence */
+				if (!ok) {
+					error("encoding of capture ", encoded.seq, " failed");
+					if (encoded.kind == SCREENSHOT) {
+						destroy(_heap, &encoded);
+						continue;
+					}
+				}
+
+				Mutex::Guard guard(_mutex);
+				if (!ok)
+					_frame_failed = true;
+				_encoded.enqueue(encoded);
+				_encoded_avail.up();
+			}
+		}
+
+	public:
+
+		/**
+		 * Constructor, called in libc context
+		 */
+		Encoder_pool(Env &env, unsigned count)
+		:
+			_env(env), _count(max(1U, min(count, (unsigned)MAX_ENCODERS)))
+		{
+			for (unsigned i = 0; i < _count; ++i) {
+				_workers[i].construct(*this);
+				if (!_workers[i]->start()) {
+					error("failed to create encoder thread");
+					_env.parent().exit(-1);
+					sleep_forever();
+				}
+			}
+		}
+
+		/**
+		 * Return true once after a stream frame failed to encode
+		 *
+		 * The frame is passed on with the regions encoded before the
+		 * failure, the next frame must thus be a key frame.
+		 */
+		bool frame_failed()
+		{
+			Mutex::Guard guard(_mutex);
+			bool const failed = _frame_failed;
+			_frame_failed = false;
+			return failed;
+		}
+
+		/**
+		 * Copy framebuffer regions for encoding, called by the service
+		 * entrypoint
+		 *
+		 * \param fb       framebuffer of the size 'screen'
+		 * \param rects    regions within the screen
+		 * \param time_us  capture time, which orders the encoding
+		 *
+		 * \return false if all snapshot buffers are in use or too many
+		 *         stream frames are held by the writer
+		 */
+		bool capture(Kind kind, void const *fb, Area screen,
+		             Rect const *rects, unsigned rect_count, uint64_t time_us)
+		{
+			Snapshot *snapshot = nullptr;
+			{
+				Mutex::Guard guard(_mutex);
+				for (unsigned i = 0; i <= _count && !snapshot; ++i)
+					if (_snapshots[i].state == Snapshot::FREE)
+						snapshot = &_snapshots[i];
+
+				if (!snapshot)
+					return false;
+
+				if (kind == FRAME) {
+					if (_frames_in_flight == MAX_FRAMES_IN_FLIGHT)
+						return false;
+					++_frames_in_flight;
+				}
+
+				snapshot->state = Snapshot::BUSY;
+			}
+
+			rect_count = min(rect_count, (unsigned)MAX_RECTS);
+
+			size_t num_bytes = 0;
+			for (unsigned i = 0; i < rect_count; ++i)
+				num_bytes += rects[i].area.count()*sizeof(uint32_t);
+
+			/* the buffer is replaced only if a capture has grown */
+			if (!snapshot->buffer.constructed()
+			 || snapshot->buffer->size() < num_bytes)
+				snapshot->buffer.construct(_env.ram(), _env.rm(), num_bytes);
+
+			/* copy the rows of each region */
+			uint32_t const *src = (uint32_t const *)fb;
+			uint32_t       *dst = snapshot->buffer->local_addr<uint32_t>();
+			for (unsigned i = 0; i < rect_count; ++i) {
+				Rect const r = rects[i];
+				size_t const row_bytes = r.area.w*sizeof(uint32_t);
+
+				if (r.area.w == screen.w) {
+					/* whole rows are contiguous */
+					memcpy(dst, &src[r.at.y*screen.w], row_bytes*r.area.h);
+					dst += r.area.count();
+					continue;
+				}
+
+				for (unsigned y = 0; y < r.area.h; ++y) {
+					memcpy(dst, &src[(r.at.y + y)*screen.w + r.at.x], row_bytes);
+					dst += r.area.w;
+				}
+			}
+
+			snapshot->kind       = kind;
+			snapshot->time_us    = time_us;
+			snapshot->screen     = screen;
+			snapshot->rect_count = rect_count;
+			for (unsigned i = 0; i < rect_count; ++i)
+				snapshot->rects[i] = rects[i];
+
+			{
+				Mutex::Guard guard(_mutex);
+				snapshot->seq   = _seq[kind]++;
+				snapshot->state = Snapshot::QUEUED;
+			}
+			_queued.up();
+			return true;
+		}
+
+		/**
+		 * Return the next encoded capture, blocks until one is available
+		 *
+		 * The capture must be passed to 'release' after use.
+		 */
+		Encoded &next_encoded()
+		{
+			for (;;) {
+				_encoded_avail.down();
+
+				Encoded *encoded = nullptr;
+				{
+					Mutex::Guard guard(_mutex);
+					_encoded.dequeue([&] (Encoded &e) { encoded = &e; });
+				}
+				if (encoded)
+					return *encoded;
+			}
+		}
+
+		void release(Encoded &encoded)
+		{
+			if (encoded.kind == FRAME) {
+				Mutex::Guard guard(_mutex);
+				--_frames_in_flight;
+			}
+			destroy(_heap, &encoded);
+		}
+};
+
+#endif /* _FLIF_CAPTURE__ENCODER_POOL_H_ */
@@ -11,10 +11,8 @@
  * under the terms of the GNU Affero General Public License version 3.
  */
 
-/* FLIF includes */
-#include <flif_enc.h>
-
 /* Libc includes */
+#include <stdio.h>
 #include <time.h>
 
 /* Genode includes */
@@ -23,163 +21,101 @@
 #include <input_session/connection.h>
 #include <input/component.h>
 #include <base/attached_dataspace.h>
+#include <base/attached_rom_dataspace.h>
+#include <timer_session/connection.h>
 #include <os/static_root.h>
-#include <os/pixel_rgb888.h>
+
+/* local includes */
+#include <encoder_pool.h>
+#include <dirty_rects.h>
+#include <stream_file.h>
 
 namespace Flif_capture {
 	using namespace Genode;
 
 	class Framebuffer_session_component;
-	class Encoder;
 	class Main;
 
 	using Framebuffer::Mode;
-
-	/**
-	 * Endian work-around struct
-	 */
-	struct RGBA
-	{
-		uint8_t r,g,b,a;
-	} __attribute__((packed));
 }
 
 
-class Flif_capture::Encoder
+class Flif_capture::Framebuffer_session_component
+:
+	public Genode::Rpc_object<Framebuffer::Session>
 {
 	private:
 
-		Genode::Env &_env;
-
-		// TODO: reuse FLIF_IMAGE, do not reallocate
-		FLIF_IMAGE  *_image = nullptr;
-		Semaphore    _semaphore { };
-		Mutex        _mutex { };
-
-	public:
-
-		bool capture_pending = false;
-
-		/* safety noise */
-		Encoder(Encoder const &);
-		Encoder &operator = (Encoder const &);
-
-		Encoder(Genode::Env &env) : _env(env) { }
-
-		/**
-		 * Encode loop called from initial thread
-		 */
-		void entry()
-		{
-			_mutex.acquire();
-
-			for (;;) {
-				while (_image == nullptr) {
-					_mutex.release();
-					_semaphore.down();
-					_mutex.acquire();
-				}
-
-				char filename[32] { '\0' };
-
-				Libc::with_libc([&] () {
-					/* calculate Sumerian time, hopefully */
-					time_t now = time(NULL);
-					struct tm more_now { };
-					localtime_r(&now, &more_now);
-					strftime(filename, sizeof(filename), "%T.flif", &more_now);
-				});
+		Genode::Env                  &_env;
+		Framebuffer::Session         &_parent;
+		Flif_capture::Encoder_pool   &_encoders;
 
-				FLIF_ENCODER* encoder = flif_create_encoder();
-				flif_encoder_set_lookback(encoder, 0);
-				if (!encoder) {
-					Genode::error("failed to create FLIF encoder");
-					continue;
-				}
+		Genode::Dataspace_capability  _dataspace { };
+		Framebuffer::Mode             _mode { };
 
-				flif_encoder_add_image(encoder, _image);
+		/* framebuffer stays attached for captures until the mode changes */
+		Constructible<Attached_dataspace> _fb_ds { };
 
-				Genode::log("capture to ", (char const *)filename);
-				Libc::with_libc([&] () {
-					if (!flif_encoder_encode_file(encoder, filename))
-						Genode::error("file encoding failed");
-				});
+		/* regions refreshed since the last stream frame */
+		Dirty_rects _dirty { };
 
-				flif_destroy_encoder(encoder);
-				flif_destroy_image(_image);
-				_image = nullptr;
-			}
-		}
+		bool _key_frame = true;
 
-		/**
-		 * Cross-thread copy called by service entrypoint
-		 */
-		void queue(Dataspace_capability fb_cap, Mode const mode)
+		bool _fb_valid()
 		{
+			if (!_fb_ds.constructed())
+				return false;
 
-			/* drop this frame if there is encoding in progress */
-			if (_image != nullptr)
-				return;
-
-			Mutex::Guard guard(_mutex);
-
-			/* TODO: attach/detach each capture? */
-			Genode::Attached_dataspace fb_ds(_env.rm(), fb_cap);
-			if (fb_ds.size() < mode.num_bytes()) {
+			if (_fb_ds->size() < _mode.num_bytes()) {
 				Genode::error("invalid framebuffer for capture");
-				return;
+				return false;
 			}
-
-			RGBA row[mode.area.w];
-
-			_image = flif_create_image(mode.area.w, mode.area.h);
-			if (!_image) {
-				Genode::error("failed to create image buffer");
-				return;
-			}
-
-			using Pixel = Pixel_rgb888;
-			Pixel const *pixels = fb_ds.local_addr<Pixel const>();
-
-			for (unsigned y = 0; y < mode.area.h; y++) {
-				for (unsigned x = 0; x < mode.area.w; x++) {
-					Pixel const px = pixels[y*mode.area.w+x];
-					row[x] = RGBA { (uint8_t)px.r(),
-					                (uint8_t)px.g(),
-					                (uint8_t)px.b(),
-					                255 };
-				}
-				flif_image_write_row_RGBA8(_image, y, row, sizeof(row));
-			}
-
-			capture_pending = false;
-			_semaphore.up();
+			return true;
 		}
-};
 
-
-class Flif_capture::Framebuffer_session_component
-:
-	public Genode::Rpc_object<Framebuffer::Session>
-{
-	private:
-
-		Genode::Env                  &_env;
-		Framebuffer::Session         &_parent;
-		Flif_capture::Encoder        &_encoder;
-
-		Genode::Dataspace_capability  _dataspace { };
-		Framebuffer::Mode             _mode { };
+		Rect _screen() const { return Rect(Framebuffer::Point(0, 0), _mode.area); }
 
 	public:
 
+		bool screenshot_pending = false;
+
 		/**
 		 * Constructor
 		 */
 		Framebuffer_session_component(Genode::Env &env,
 		                              Framebuffer::Session &client,
-		                              Flif_capture::Encoder &encoder)
-		: _env(env), _parent(client), _encoder(encoder) { }
+		                              Flif_capture::Encoder_pool &encoders)
+		: _env(env), _parent(client), _encoders(encoders) { }
+
+		/**
+		 * Capture the regions that changed since the last stream frame
+		 *
+		 * If the capture is refused, the regions are retained for the
+		 * next attempt, so no change is missing from the stream.
+		 */
+		void capture_frame(uint64_t time_us)
+		{
+			if (!_fb_valid())
+				return;
+
+			/* the changes of a failed frame are restored by a key frame */
+			if (_encoders.frame_failed())
+				_key_frame = true;
+
+			Rect const screen = _screen();
+
+			bool const captured = _key_frame
+				? _encoders.capture(FRAME, _fb_ds->local_addr<void const>(),
+				                    _mode.area, &screen, 1, time_us)
+				: !_dirty.empty()
+				&& _encoders.capture(FRAME, _fb_ds->local_addr<void const>(),
+				                     _mode.area, _dirty.rects(), _dirty.count(),
+				                     time_us);
+			if (captured) {
+				_key_frame = false;
+				_dirty.clear();
+			}
+		}
 
 
 		/************************************
@@ -190,6 +126,14 @@ class Flif_capture::Framebuffer_session_component
 		{
 			_mode = _parent.mode();
 			_dataspace = _parent.dataspace();
+
+			_fb_ds.destruct();
+			if (_dataspace.valid())
+				_fb_ds.construct(_env.rm(), _dataspace);
+
+			_dirty.clear();
+			_key_frame = true;
+
 			return _dataspace;
 		}
 
@@ -206,8 +150,18 @@ class Flif_capture::Framebuffer_session_component
 		void refresh(Framebuffer::Rect rect) override
 		{
 			_parent.refresh(rect);
-			if (_encoder.capture_pending)
-				_encoder.queue(_dataspace, _mode);
+
+			_dirty.add(Rect::intersect(rect, _screen()));
+
+			if (!screenshot_pending || !_fb_valid())
+				return;
+
+			screenshot_pending = false;
+
+			Rect const screen = _screen();
+			if (!_encoders.capture(SCREENSHOT, _fb_ds->local_addr<void const>(),
+			                       _mode.area, &screen, 1, 0))
+				Genode::warning("capture dropped, all encoders are busy");
 		}
 
 		void sync_sigh(Genode::Signal_context_capability sigh) override
@@ -219,6 +173,8 @@ class Flif_capture::Framebuffer_session_component
 
 		Blit_result blit(Framebuffer::Blit_batch const &batch) override
 		{
+			/* the moved regions are not tracked individually */
+			_dirty.add(_screen());
 			return _parent.blit(batch);
 		}
 
@@ -250,12 +206,20 @@ class Flif_capture::Main : private Input::Session_component::Action
 			_env.cpu().affinity_space().location_of_index(1)
 		};
 
-		Flif_capture::Encoder   _encoder      { _env };
+		Attached_rom_dataspace _config_rom { _env, "config" };
+
+		Flif_capture::Encoder_pool _encoders {
+			_env, _config_rom.node().attribute_value("encoders", 1U) };
+
+		Timer::Connection _timer { _env };
+
+		Constructible<Stream_file> _stream { };
+
 		Framebuffer::Connection _parent_fb    { _env, Mode { } };
 		Input::Connection       _parent_input { _env };
 
 		Framebuffer_session_component _fb_session {
-			_env, _parent_fb, _encoder };
+			_env, _parent_fb, _encoders };
 
 		Input::Session_component _input_session {
 			_env.ep(), _env.ram(), _env.rm(), *this };
@@ -280,7 +244,7 @@ class Flif_capture::Main : private Input::Session_component::Action
 				queue.add(e, SUBMIT_LATER);
 
 				if (e.key_release(_capture_code)) {
-					_encoder.capture_pending = true;
+					_fb_session.screenshot_pending = true;
 				}
 			});
 
@@ -292,6 +256,40 @@ class Flif_capture::Main : private Input::Session_component::Action
 
 		Genode::Static_root<Input::Session> _input_root { _input_session.cap() };
 
+		Genode::Signal_handler<Main> _frame_handler {
+			_service_ep, *this, &Main::_handle_frame };
+
+		void _handle_frame() { _fb_session.capture_frame(_timer.elapsed_us()); }
+
+		void _write_screenshot(Encoded const &capture)
+		{
+			if (!capture.rect_count)
+				return;
+
+			char filename[32] { '\0' };
+
+			Libc::with_libc([&] () {
+				/* calculate Sumerian time, hopefully */
+				time_t now = time(NULL);
+				struct tm more_now { };
+				localtime_r(&now, &more_now);
+
+				char stamp[16] { '\0' };
+				strftime(stamp, sizeof(stamp), "%T", &more_now);
+				snprintf(filename, sizeof(filename), "%s-%u.flif", stamp, capture.seq);
+			});
+
+			Genode::log("capture to ", (char const *)filename);
+			Libc::with_libc([&] () {
+				FILE *file = fopen(filename, "w");
+				if (!file || fwrite(capture.data[0], 1, capture.size[0], file)
+				             != capture.size[0])
+					Genode::error("file encoding failed");
+				if (file)
+					fclose(file);
+			});
+		}
+
 	public:
 
 		/**
@@ -308,9 +306,39 @@ class Flif_capture::Main : private Input::Session_component::Action
 			env.parent().announce(_service_ep.manage(_input_root));
 
 			Genode::log("--- screenshot capture key is ", Input::key_name(_capture_code), " ---");
+
+			_config_rom.node().with_optional_sub_node("stream", [&] (Node const &node) {
+				Stream_file::Path const path =
+					node.attribute_value("file", Stream_file::Path("capture.flifs"));
+				unsigned const fps =
+					max(1U, min(node.attribute_value("fps", 5U), 60U));
+
+				_stream.construct(_encoders, path);
+
+				_timer.sigh(_frame_handler);
+				_timer.trigger_periodic(1000*1000/fps);
+
+				Genode::log("--- streaming at ", fps, " fps to ", path, " ---");
+			});
 		}
 
-		void spin() { _encoder.entry(); }
+		/**
+		 * Write loop called from initial thread
+		 */
+		void spin()
+		{
+			for (;;) {
+				Encoded &capture = _encoders.next_encoded();
+
+				if (capture.kind == FRAME && _stream.constructed()) {
+					_stream->submit(capture);
+					continue;
+				}
+
+				_write_screenshot(capture);
+				_encoders.release(capture);
+			}
+		}
 };
 
 
@@ -0,0 +1,152 @@
+/*
+ * \brief  Stream of captured frames
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _FLIF_CAPTURE__STREAM_FILE_H_
+#define _FLIF_CAPTURE__STREAM_FILE_H_
+
+/* Libc includes */
+#include <stdio.h>
+
+/* Genode includes */
+#include <libc/component.h>
+#include <util/string.h>
+
+/* local includes */
+#include <encoder_pool.h>
+
+namespace Flif_capture { class Stream_file; }
+
+
+/**
+ * Writer of frames in capture order
+ *
+ * The file starts with the magic "FLIFSTRM" and a 32-bit version. Each
+ * frame is a record of little-endian fields:
+ *
+ *   u64 time_us, u32 screen width, u32 screen height, u32 region count
+ *
+ * followed by the regions:
+ *
+ *   i32 x, i32 y, u32 width, u32 height, u32 size, FLIF image of 'size' bytes
+ *
+ * A frame replaces the regions it contains in the preceding frame. The
+ * first frame and every frame after a mode change is a key frame with a
+ * single region that covers the screen.
+ *
+ * Frames arrive from the encoders out of order and are held back until
+ * their predecessors are written. Must be used by the initial thread.
+ */
+class Flif_capture::Stream_file
+{
+	public:
+
+		typedef String<128> Path;
+
+		enum { VERSION = 1 };
+
+	private:
+
+		Encoder_pool &_encoders;
+
+		FILE *_file = nullptr;
+
+		unsigned _next_seq = 0;
+
+		/* frames that arrived ahead of their predecessors */
+		Encoded *_held[Encoder_pool::MAX_FRAMES_IN_FLIGHT] { };
+
+		bool _write(void const *data, size_t size) {
+			return _file && fwrite(data, 1, size, _file) == size; }
+
+		template <typename T>
+		bool _write(T const &value) { return _write(&value, sizeof(value)); }
+
+		void _append(Encoded const &frame)
+		{
+			bool ok = _write((uint64_t)frame.time_us)
+			       && _write((uint32_t)frame.screen.w)
+			       && _write((uint32_t)frame.screen.h)
+			       && _write((uint32_t)frame.rect_count);
+
+			for (unsigned i = 0; ok && i < frame.rect_count; ++i) {
+				Rect const r = frame.rects[i];
+				ok = _write((int32_t)r.at.x)
+				  && _write((int32_t)r.at.y)
+				  && _write((uint32_t)r.area.w)
+				  && _write((uint32_t)r.area.h)
+				  && _write((uint32_t)frame.size[i])
+				  && _write(frame.data[i], frame.size[i]);
+			}
+
+			if (!ok) {
+				error("failed to write frame ", frame.seq, " to stream");
+				return;
+			}
+			fflush(_file);
+		}
+
+	public:
+
+		Stream_file(Encoder_pool &encoders, Path const &path)
+		:
+			_encoders(encoders)
+		{
+			Libc::with_libc([&] () {
+				_file = fopen(path.string(), "w");
+				if (!_file || !_write("FLIFSTRM", 8) || !_write((uint32_t)VERSION))
+					error("failed to create stream file ", path);
+			});
+		}
+
+		~Stream_file()
+		{
+			Libc::with_libc([&] () { if (_file) fclose(_file); });
+		}
+
+		/**
+		 * Take an encoded frame and write all frames that are in order
+		 */
+		void submit(Encoded &frame)
+		{
+			bool held = false;
+			for (Encoded *&slot : _held)
+				if (!slot) {
+					slot = &frame;
+					held = true;
+					break;
+				}
+
+			/* the pool limits the frames in flight to the number of slots */
+			if (!held) {
+				error("stream frame ", frame.seq, " out of sequence");
+				_encoders.release(frame);
+				return;
+			}
+
+			for (bool progress = true; progress; ) {
+				progress = false;
+				for (Encoded *&slot : _held) {
+					if (!slot || slot->seq != _next_seq)
+						continue;
+
+					Libc::with_libc([&] () { _append(*slot); });
+					_encoders.release(*slot);
+					slot = nullptr;
+					++_next_seq;
+					progress = true;
+				}
+			}
+		}
+};
+
+#endif /* _FLIF_CAPTURE__STREAM_FILE_H_ */
@@ -0,0 +1,64 @@
+/*
+ * \brief  Conversion of framebuffer pixels to RGBA
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _FLIF_CAPTURE__SWIZZLE_H_
+#define _FLIF_CAPTURE__SWIZZLE_H_
+
+/* Genode includes */
+#include <base/stdint.h>
+
+namespace Flif_capture {
+
+	/**
+	 * Convert little-endian XRGB pixels to RGBA bytes with opaque alpha
+	 *
+	 * Four pixels are processed per iteration using the GCC vector
+	 * extension, which is lowered to SSSE3 or NEON where available.
+	 *
+	 * The conversion may be done in place, with 'dst' equal to 'src'.
+	 *
+	 * \param src     pixels as stored in the framebuffer (B, G, R, X)
+	 * \param dst     destination of 'count' RGBA quadruples
+	 * \param count   number of pixels
+	 */
+	static inline void xrgb_to_rgba(Genode::uint32_t const *src,
+	                                Genode::uint8_t *dst,
+	                                Genode::size_t count)
+	{
+		typedef Genode::uint8_t Vec  __attribute__((vector_size(16)));
+
+		/* vector access at pixel alignment */
+		typedef Genode::uint8_t Unaligned_vec
+			__attribute__((vector_size(16), aligned(1), may_alias));
+
+		/* indices of 16 and above select the opaque alpha */
+		Vec const mask { 2, 1, 0, 16, 6, 5, 4, 16, 10, 9, 8, 16, 14, 13, 12, 16 };
+		Vec const opaque = (Vec){ } + 0xff;
+
+		Genode::size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			Vec const v = *(Unaligned_vec const *)&src[i];
+			*(Unaligned_vec *)&dst[i*4] = __builtin_shuffle(v, opaque, mask);
+		}
+
+		for (; i < count; ++i) {
+			Genode::uint32_t const px = src[i];
+			dst[i*4 + 0] = (Genode::uint8_t)(px >> 16);
+			dst[i*4 + 1] = (Genode::uint8_t)(px >>  8);
+			dst[i*4 + 2] = (Genode::uint8_t)(px);
+			dst[i*4 + 3] = 0xff;
+		}
+	}
+}
+
+#endif /* _FLIF_CAPTURE__SWIZZLE_H_ */
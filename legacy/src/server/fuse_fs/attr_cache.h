@@ -0,0 +1,204 @@
+/*
+ * \brief  Cache of node attributes
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _ATTR_CACHE_H_
+#define _ATTR_CACHE_H_
+
+/* Genode includes */
+#include <base/mutex.h>
+#include <file_system_session/file_system_session.h>
+#include <libc/component.h>
+#include <timer_session/connection.h>
+#include <util/string.h>
+
+/* libc includes */
+#include <sys/stat.h>
+
+#include <fuse.h>
+#include <fuse_private.h>
+
+/* local includes */
+#include <driver.h>
+
+namespace Fuse_fs {
+	class Attr_cache;
+
+	/**
+	 * Attribute cache of the component
+	 */
+	Attr_cache &attr_cache();
+}
+
+
+/**
+ * Attributes of recently looked-up paths
+ *
+ * The results of 'op.getattr' are kept for a configurable time to live,
+ * so lookups, status requests, and appends do not call into the FUSE
+ * driver for each operation. As all changes to the volume pass through
+ * this component, writes and truncations update the cached size in
+ * place and namespace changes drop the affected entries.
+ *
+ * The cache is direct mapped by a hash of the path, a colliding lookup
+ * evicts the previous entry.
+ */
+class Fuse_fs::Attr_cache
+{
+	public:
+
+		enum { SLOTS = 1024 };
+
+	private:
+
+		struct Slot
+		{
+			bool                    used = false;
+			unsigned long           hash = 0;
+			Genode::uint64_t        time_ms = 0;
+			struct stat             attr { };
+			char                    path[File_system::MAX_PATH_LEN] { };
+		};
+
+		Timer::Connection      _timer;
+		Genode::uint64_t const _ttl_ms;
+
+		Genode::Mutex _mutex { };
+
+		Slot _slots[SLOTS] { };
+
+		static unsigned long _hash(char const *path)
+		{
+			/* FNV-1a */
+			unsigned long h = 2166136261UL;
+			for (; *path; ++path)
+				h = (h ^ (unsigned char)*path) * 16777619UL;
+			return h;
+		}
+
+		Slot &_slot(unsigned long hash) { return _slots[hash % SLOTS]; }
+
+		bool _matches(Slot const &slot, unsigned long hash, char const *path) const {
+			return slot.used && slot.hash == hash && Genode::strcmp(slot.path, path) == 0; }
+
+		/*
+		 * The time is interpolated locally and does not involve an RPC
+		 * to the timer for each lookup.
+		 */
+		Genode::uint64_t _now_ms() {
+			return _timer.curr_time().trunc_to_plain_ms().value; }
+
+		bool _fresh(Slot const &slot, Genode::uint64_t now_ms) const {
+			return now_ms - slot.time_ms < _ttl_ms; }
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param ttl_ms  time to live of an entry, 0 disables the cache
+		 */
+		Attr_cache(Genode::Env &env, Genode::uint64_t ttl_ms)
+		: _timer(env, "attr_cache"), _ttl_ms(ttl_ms) { }
+
+		/**
+		 * Get the attributes of a path
+		 *
+		 * \return result of 'op.getattr', 0 on success
+		 */
+		int getattr(char const *path, struct stat &attr)
+		{
+			unsigned long const hash = _hash(path);
+
+			if (_ttl_ms) {
+				Genode::uint64_t const now_ms = _now_ms();
+
+				Genode::Mutex::Guard guard(_mutex);
+				Slot &slot = _slot(hash);
+				if (_matches(slot, hash, path) && _fresh(slot, now_ms)) {
+					attr = slot.attr;
+					return 0;
+				}
+			}
+
+			int res = -1;
+			with_driver([&] () {
+				res = Fuse::fuse()->op.getattr(path, &attr);
+			});
+
+			if (res != 0 || !_ttl_ms
+			 || Genode::strlen(path) >= File_system::MAX_PATH_LEN)
+				return res;
+
+			Genode::uint64_t const now_ms = _now_ms();
+
+			Genode::Mutex::Guard guard(_mutex);
+			Slot &slot = _slot(hash);
+			slot.used    = true;
+			slot.hash    = hash;
+			slot.time_ms = now_ms;
+			slot.attr    = attr;
+			Genode::copy_cstring(slot.path, path, sizeof(slot.path));
+			return 0;
+		}
+
+		/**
+		 * Update the cached size of a file after a write
+		 */
+		void written(char const *path, Genode::uint64_t end)
+		{
+			unsigned long const hash = _hash(path);
+
+			Genode::Mutex::Guard guard(_mutex);
+			Slot &slot = _slot(hash);
+			if (_matches(slot, hash, path) && (Genode::uint64_t)slot.attr.st_size < end)
+				slot.attr.st_size = end;
+		}
+
+		/**
+		 * Update the cached size of a file after a truncation
+		 */
+		void truncated(char const *path, Genode::uint64_t size)
+		{
+			unsigned long const hash = _hash(path);
+
+			Genode::Mutex::Guard guard(_mutex);
+			Slot &slot = _slot(hash);
+			if (_matches(slot, hash, path))
+				slot.attr.st_size = size;
+		}
+
+		/**
+		 * Drop the entry of a path
+		 */
+		void invalidate(char const *path)
+		{
+			unsigned long const hash = _hash(path);
+
+			Genode::Mutex::Guard guard(_mutex);
+			Slot &slot = _slot(hash);
+			if (_matches(slot, hash, path))
+				slot.used = false;
+		}
+
+		/**
+		 * Drop all entries, e.g., after a directory was renamed
+		 */
+		void invalidate_all()
+		{
+			Genode::Mutex::Guard guard(_mutex);
+			for (unsigned i = 0; i < SLOTS; ++i)
+				_slots[i].used = false;
+		}
+};
+
+#endif /* _ATTR_CACHE_H_ */
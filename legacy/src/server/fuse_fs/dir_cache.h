@@ -0,0 +1,178 @@
+/*
+ * \brief  Cache of directory entries
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _DIR_CACHE_H_
+#define _DIR_CACHE_H_
+
+/* Genode includes */
+#include <base/log.h>
+#include <util/misc_math.h>
+#include <util/string.h>
+
+/* libc includes */
+#include <sys/dirent.h>
+#include <sys/stat.h>
+#include <stdlib.h>
+
+#include <fuse.h>
+#include <fuse_private.h>
+
+namespace Fuse_fs {
+	class Dir_cache;
+}
+
+
+/**
+ * Entries of an open directory
+ *
+ * The directory is read by a single 'op.readdir' call into arrays that
+ * grow as needed, so reading all entries one by one is linear in the
+ * number of entries. Names are stored back to back in a separate
+ * buffer. A cache is refilled if the file-system namespace changed
+ * after it was filled, which is tracked by a generation counter that is
+ * advanced on each create, unlink, and rename.
+ */
+class Fuse_fs::Dir_cache
+{
+	public:
+
+		struct Entry
+		{
+			Genode::size_t name_offset;
+			unsigned char  type; /* DT_* */
+		};
+
+	private:
+
+		Dir_cache(Dir_cache const &);
+		Dir_cache &operator = (Dir_cache const &);
+
+		Entry          *_entries          = nullptr;
+		Genode::size_t  _entries_capacity = 0;
+		Genode::size_t  _count            = 0;
+
+		char           *_names          = nullptr;
+		Genode::size_t  _names_capacity = 0;
+		Genode::size_t  _names_size     = 0;
+
+		unsigned long _generation = 0;
+		bool          _filled     = false;
+
+		static unsigned long &_namespace_generation()
+		{
+			static unsigned long generation = 1;
+			return generation;
+		}
+
+		template <typename T>
+		static bool _reserve(T *&array, Genode::size_t &capacity,
+		                     Genode::size_t needed)
+		{
+			if (needed <= capacity)
+				return true;
+
+			Genode::size_t const new_capacity =
+				Genode::max(capacity*2, Genode::max(needed, Genode::size_t(64)));
+
+			T *new_array = (T *)::realloc(array, new_capacity*sizeof(T));
+			if (!new_array)
+				return false;
+
+			array    = new_array;
+			capacity = new_capacity;
+			return true;
+		}
+
+		/**
+		 * Filler passed to 'op.readdir', returns non-zero if full
+		 */
+		static int _filler(void *buf, char const *name,
+		                   struct stat const *sbuf, off_t)
+		{
+			Dir_cache &cache = *(Dir_cache *)buf;
+
+			Genode::size_t const len = Genode::strlen(name) + 1;
+
+			if (!_reserve(cache._entries, cache._entries_capacity, cache._count + 1)
+			 || !_reserve(cache._names, cache._names_capacity, cache._names_size + len)) {
+				Genode::warning("directory cache out of memory");
+				return 1;
+			}
+
+			Entry &e = cache._entries[cache._count++];
+			e.name_offset = cache._names_size;
+			e.type        = sbuf ? IFTODT(sbuf->st_mode) : DT_UNKNOWN;
+
+			Genode::memcpy(&cache._names[cache._names_size], name, len);
+			cache._names_size += len;
+
+			return 0;
+		}
+
+	public:
+
+		Dir_cache() { }
+
+		~Dir_cache()
+		{
+			::free(_entries);
+			::free(_names);
+		}
+
+		/**
+		 * Invalidate the caches of all directories
+		 */
+		static void namespace_changed() {
+			__atomic_add_fetch(&_namespace_generation(), 1, __ATOMIC_SEQ_CST); }
+
+		bool valid() const
+		{
+			return _filled && _generation ==
+				__atomic_load_n(&_namespace_generation(), __ATOMIC_SEQ_CST);
+		}
+
+		/**
+		 * Read the directory into the cache
+		 *
+		 * Must be called from libc context.
+		 *
+		 * \return false if 'op.readdir' failed
+		 */
+		bool fill(char const *path, struct fuse_file_info *file_info)
+		{
+			_count      = 0;
+			_names_size = 0;
+			_generation = __atomic_load_n(&_namespace_generation(), __ATOMIC_SEQ_CST);
+
+			int const res = Fuse::fuse()->op.readdir(path, this, &_filler, 0,
+			                                         file_info);
+			_filled = (res == 0);
+			return _filled;
+		}
+
+		Genode::size_t count() const { return _count; }
+
+		char const *name(Genode::size_t index) const {
+			return &_names[_entries[index].name_offset]; }
+
+		unsigned char type(Genode::size_t index) const {
+			return _entries[index].type; }
+
+		/**
+		 * Store the type of an entry that was not reported by 'readdir'
+		 */
+		void type(Genode::size_t index, unsigned char type) {
+			_entries[index].type = type; }
+};
+
+#endif /* _DIR_CACHE_H_ */
@@ -27,6 +27,9 @@
 #include <unistd.h>
 
 /* local includes */
+#include <attr_cache.h>
+#include <dir_cache.h>
+#include <driver.h>
 #include <file.h>
 #include <mode_util.h>
 #include <node.h>
@@ -51,20 +54,15 @@ class Fuse_fs::Directory : public Node
 		struct fuse_file_info  _file_info;
 		Path                   _path;
 		Allocator             &_alloc;
+		Dir_cache              _cache { };
 
 		/**
 		 * Check if the given path points to a directory
 		 */
 		bool _is_dir(char const *path)
 		{
-			bool result = true;
-			Libc::with_libc([&] () {
-				struct stat s;
-				if (Fuse::fuse()->op.getattr(path, &s) != 0 || ! S_ISDIR(s.st_mode))
-					result = false;
-			});
-
-			return result;
+			struct stat s;
+			return attr_cache().getattr(path, s) == 0 && S_ISDIR(s.st_mode);
 		}
 
 		void _open_path(char const *path, bool create)
@@ -73,7 +71,7 @@ class Fuse_fs::Directory : public Node
 
 			if (create) {
 
-				Libc::with_libc([&] () {
+				with_driver([&] () {
 					res = Fuse::fuse()->op.mkdir(path, 0755);
 				});
 
@@ -102,9 +100,11 @@ class Fuse_fs::Directory : public Node
 							throw Lookup_failed();
 					}
 				}
+
+				Dir_cache::namespace_changed();
 			}
 
-			Libc::with_libc([&] () {
+			with_driver([&] () {
 				res = Fuse::fuse()->op.opendir(path, &_file_info);
 			});
 
@@ -133,31 +133,73 @@ class Fuse_fs::Directory : public Node
 			}
 		}
 
-		size_t _num_entries()
+		/**
+		 * Make sure the entry cache is up to date
+		 *
+		 * The cache is shared with the workers and must only be accessed
+		 * from within 'with_driver'.
+		 *
+		 * \return false if the directory could not be read
+		 */
+		bool _update_cache()
 		{
-			char buf[4096];
-
-			Genode::memset(buf, 0, sizeof (buf));
-
-			struct fuse_dirhandle dh = {
-				.filler = Fuse::fuse()->filler,
-				.buf    = buf,
-				.size   = sizeof (buf),
-				.offset = 0,
-			};
+			if (_cache.valid())
+				return true;
 
-			int res = -1;
+			return _cache.fill(_path.base(), &_file_info);
+		}
 
-			Libc::with_libc([&] () {
-				res = Fuse::fuse()->op.readdir(_path.base(), &dh,
-				                               Fuse::fuse()->filler, 0,
-				                               &_file_info);
+		size_t _num_entries()
+		{
+			size_t count = 0;
+			with_driver([&] () {
+				if (_update_cache())
+					count = _cache.count();
 			});
+			return count;
+		}
 
-			if (res != 0)
-				return 0;
+		/**
+		 * Fill in the directory entry at the given index of the cache
+		 *
+		 * \return false if there is no entry of a supported type
+		 */
+		bool _read_entry(Directory_entry &e, seek_off_t index)
+		{
+			if (!_update_cache() || index >= _cache.count())
+				return false;
+
+			switch (_cache.type(index)) {
+			case DT_REG: e.type = File_system::Node_type::CONTINUOUS_FILE; break;
+			case DT_DIR: e.type = File_system::Node_type::DIRECTORY;       break;
+			case DT_LNK: e.type = File_system::Node_type::SYMLINK;         break;
+			/**
+			 * There are FUSE file system implementations that do not fill-out
+			 * d_type when calling readdir(). We mark these entries by setting
+			 * their type to DT_UNKNOWN in our libfuse implementation. Afterwards
+			 * we call getattr() on each entry that, hopefully, will yield proper
+			 * results. The result is kept in the cache.
+			 */
+			case DT_UNKNOWN:
+			{
+				Genode::Path<4096> path(_cache.name(index), _path.base());
+				struct stat sbuf;
+				if (attr_cache().getattr(path.base(), sbuf) == 0) {
+					switch (IFTODT(sbuf.st_mode)) {
+					case DT_REG: e.type = File_system::Node_type::CONTINUOUS_FILE; break;
+					case DT_DIR: e.type = File_system::Node_type::DIRECTORY;       break;
+					}
+					_cache.type(index, IFTODT(sbuf.st_mode));
+					/* break outer switch */
+					break;
+				}
+			}
+			default:
+				return false;
+			}
 
-			return dh.offset / sizeof (struct dirent);
+			copy_cstring(e.name.buf, _cache.name(index), sizeof(e.name.buf));
+			return true;
 		}
 
 	public:
@@ -176,7 +218,7 @@ class Fuse_fs::Directory : public Node
 
 		virtual ~Directory()
 		{
-			Libc::with_libc([&] () {
+			with_driver([&] () {
 				Fuse::fuse()->op.release(_path.base(), &_file_info);
 			});
 		}
@@ -186,12 +228,7 @@ class Fuse_fs::Directory : public Node
 			Path node_path(path, _path.base());
 
 			struct stat s;
-			int res = -1;
-
-			Libc::with_libc([&] () {
-				res = Fuse::fuse()->op.getattr(node_path.base(), &s);
-			});
-			if (res != 0)
+			if (attr_cache().getattr(node_path.base(), s) != 0)
 				throw Lookup_failed();
 
 			Node *node = 0;
@@ -213,12 +250,7 @@ class Fuse_fs::Directory : public Node
 		Status status() override
 		{
 			struct stat s;
-			int res = -1;
-
-			Libc::with_libc([&] () {
-				res = Fuse::fuse()->op.getattr(_path.base(), &s);
-			});
-			if (res != 0)
+			if (attr_cache().getattr(_path.base(), s) != 0)
 				return Status();
 
 			Status status;
@@ -243,71 +275,12 @@ class Fuse_fs::Directory : public Node
 
 			seek_off_t index = seek_offset / sizeof(Directory_entry);
 
-			char buf[4096];
-
-			Genode::memset(buf, 0, sizeof (buf));
-			struct dirent *de = (struct dirent *)buf;
-
-			struct fuse_dirhandle dh = {
-				.filler = Fuse::fuse()->filler,
-				.buf    = buf,
-				.size   = sizeof (buf),
-				.offset = 0,
-			};
-
-			int res = -1;
-
-			Libc::with_libc([&] () {
-				res = Fuse::fuse()->op.readdir(_path.base(), &dh,
-				                               Fuse::fuse()->filler, 0,
-				                               &_file_info);
-			});
-			if (res != 0)
-				return 0;
-
-			if (index > (seek_off_t)(dh.offset / sizeof (struct dirent)))
-				return 0;
-
-			struct dirent *dent = de + index;
-			if (!dent)
-				return 0;
-
-			Directory_entry *e = (Directory_entry *)(dst);
-
-			switch (dent->d_type) {
-			case DT_REG: e->type = File_system::Node_type::CONTINUOUS_FILE; break;
-			case DT_DIR: e->type = File_system::Node_type::DIRECTORY;       break;
-			case DT_LNK: e->type = File_system::Node_type::SYMLINK;         break;
-			/**
-			 * There are FUSE file system implementations that do not fill-out
-			 * d_type when calling readdir(). We mark these entries by setting
-			 * their type to DT_UNKNOWN in our libfuse implementation. Afterwards
-			 * we call getattr() on each entry that, hopefully, will yield proper
-			 * results.
-			 */
-			case DT_UNKNOWN:
-			{
-				Genode::Path<4096> path(dent->d_name, _path.base());
-				struct stat sbuf;
-				Libc::with_libc([&] () {
-					res = Fuse::fuse()->op.getattr(path.base(), &sbuf);
-				});
-				if (res == 0) {
-					switch (IFTODT(sbuf.st_mode)) {
-					case DT_REG: e->type = File_system::Node_type::CONTINUOUS_FILE; break;
-					case DT_DIR: e->type = File_system::Node_type::DIRECTORY;       break;
-					}
-					/* break outer switch */
-					break;
-				}
-			}
-			default:
-				return 0;
-			}
+			Directory_entry &e = *(Directory_entry *)(dst);
 
-			copy_cstring(e->name.buf, dent->d_name, sizeof(e->name.buf));
+			bool read = false;
+			with_driver([&] () { read = _read_entry(e, index); });
 
-			return sizeof(Directory_entry);
+			return read ? sizeof(Directory_entry) : 0;
 		}
 
 		size_t write(char const *src, size_t len, seek_off_t seek_offset) override
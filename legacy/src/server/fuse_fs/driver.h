@@ -0,0 +1,89 @@
+/*
+ * \brief  Serialized access to the FUSE driver
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _DRIVER_H_
+#define _DRIVER_H_
+
+/* Genode includes */
+#include <base/thread.h>
+#include <libc/component.h>
+
+/* libc includes */
+#include <pthread.h>
+
+namespace Fuse_fs { struct Driver_access; }
+
+
+/**
+ * The FUSE drivers are not reentrant, so calls into a driver are
+ * serialized by a recursive libc mutex. The mutex is acquired in libc
+ * context on the entrypoint as well as on worker threads, which lets the
+ * entrypoint process I/O signals while it waits for a worker that holds
+ * the mutex and is itself blocked on I/O.
+ */
+struct Fuse_fs::Driver_access
+{
+	static pthread_mutex_t &mutex()
+	{
+		static pthread_mutex_t mutex;
+		return mutex;
+	}
+
+	static Genode::Thread const *&ep_thread()
+	{
+		static Genode::Thread const *thread = nullptr;
+		return thread;
+	}
+
+	/**
+	 * Initialize the mutex, must be called from the entrypoint in
+	 * libc context before any other thread accesses the driver
+	 */
+	static void init()
+	{
+		ep_thread() = Genode::Thread::myself();
+
+		pthread_mutexattr_t attr;
+		pthread_mutexattr_init(&attr);
+		pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+		pthread_mutex_init(&mutex(), &attr);
+		pthread_mutexattr_destroy(&attr);
+	}
+};
+
+
+namespace Fuse_fs {
+
+	/**
+	 * Execute code that calls into the FUSE driver
+	 *
+	 * On the entrypoint the code is executed in libc context, worker
+	 * threads are libc threads already.
+	 */
+	template <typename FN>
+	static inline void with_driver(FN const &fn)
+	{
+		auto locked_fn = [&] () {
+			pthread_mutex_lock(&Driver_access::mutex());
+			fn();
+			pthread_mutex_unlock(&Driver_access::mutex());
+		};
+
+		if (Genode::Thread::myself() == Driver_access::ep_thread())
+			Libc::with_libc(locked_fn);
+		else
+			locked_fn();
+	}
+}
+
+#endif /* _DRIVER_H_ */
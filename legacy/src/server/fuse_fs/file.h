@@ -17,8 +17,12 @@
 #define _FILE_H_
 
 /* local includes */
+#include <attr_cache.h>
+#include <dir_cache.h>
+#include <driver.h>
 #include <mode_util.h>
 #include <node.h>
+#include <write_buffer.h>
 
 #include <fuse.h>
 #include <fuse_private.h>
@@ -39,13 +43,15 @@ class Fuse_fs::File : public Node
 
 		struct fuse_file_info  _file_info;
 
+		Genode::Constructible<Write_buffer> _write_buffer { };
+
 		void _open_path(char const *path, Mode mode, bool create, bool trunc)
 		{
 			int res;
 			int tries = 0;
 			do {
 				/* first try to open pathname */
-				Libc::with_libc([&] () {
+				with_driver([&] () {
 					res = Fuse::fuse()->op.open(path, &_file_info);
 				});
 				if (res == 0) {
@@ -56,11 +62,12 @@ class Fuse_fs::File : public Node
 				if (create && !tries) {
 					mode_t mode = S_IFREG | 0644;
 					int res = -1;
-					Libc::with_libc([&] () {
+					with_driver([&] () {
 						res = Fuse::fuse()->op.mknod(path, mode, 0);
 					});
 					switch (res) {
 						case 0:
+							Dir_cache::namespace_changed();
 							break;
 						default:
 							Genode::error("could not create '", path, "'");
@@ -78,30 +85,44 @@ class Fuse_fs::File : public Node
 			while (true);
 
 			if (trunc) {
-				Libc::with_libc([&] () {
+				with_driver([&] () {
+					/* content buffered by other handles predates the truncation */
+					write_back().flush(path);
 					res = Fuse::fuse()->op.ftruncate(path, 0, &_file_info);
 				});
 
 				if (res != 0) {
-					Libc::with_libc([&] () {
+					with_driver([&] () {
 						Fuse::fuse()->op.release(path, &_file_info);
 					});
 					throw Lookup_failed();
 				}
+
+				attr_cache().truncated(path, 0);
 			}
 		}
 
+		/**
+		 * Buffered content may extend the file beyond the size known
+		 * to the driver
+		 */
+		file_size_t _buffered_end()
+		{
+			file_size_t end = 0;
+			with_driver([&] () {
+				if (!_write_buffer->empty())
+					end = _write_buffer->end();
+			});
+			return end;
+		}
+
 		size_t _length()
 		{
 			struct stat s;
-			int res = -1;
-			Libc::with_libc([&] () {
-				res = Fuse::fuse()->op.getattr(_path.base(), &s);
-			});
-			if (res != 0)
+			if (attr_cache().getattr(_path.base(), s) != 0)
 				return 0;
 
-			return s.st_size;
+			return Genode::max((file_size_t)s.st_size, _buffered_end());
 		}
 
 	public:
@@ -114,11 +135,15 @@ class Fuse_fs::File : public Node
 			_path(name, _parent->name())
 		{
 			_open_path(_path.base(), mode, create, trunc);
+
+			with_driver([&] () {
+				_write_buffer.construct(_path.base(), _file_info); });
 		}
 
 		~File()
 		{
-			Libc::with_libc([&] () {
+			with_driver([&] () {
+				_write_buffer.destruct();
 				Fuse::fuse()->op.release(_path.base(), &_file_info);
 			});
 		}
@@ -128,16 +153,12 @@ class Fuse_fs::File : public Node
 		Status status() override
 		{
 			struct stat s;
-			int res = -1;
-			Libc::with_libc([&] () {
-				res = Fuse::fuse()->op.getattr(_path.base(), &s);
-			});
-			if (res != 0)
+			if (attr_cache().getattr(_path.base(), s) != 0)
 				return Status();
 
 			Status status;
 			status.inode = s.st_ino ? s.st_ino : 1;
-			status.size = s.st_size;
+			status.size = Genode::max((file_size_t)s.st_size, _buffered_end());
 			status.type = File_system::Node_type::CONTINUOUS_FILE;
 			return status;
 		}
@@ -149,7 +170,10 @@ class Fuse_fs::File : public Node
 				seek_offset = _length();
 
 			int ret = -1;
-			Libc::with_libc([&] () {
+			with_driver([&] () {
+				/* the range may be buffered by any handle of the file */
+				write_back().flush(_path.base(), seek_offset, len);
+
 				ret = Fuse::fuse()->op.read(_path.base(), dst, len,
 				                            seek_offset, &_file_info);
 			});
@@ -163,22 +187,43 @@ class Fuse_fs::File : public Node
 				seek_offset = _length();
 
 			int ret = -1;
-			Libc::with_libc([&] () {
+			with_driver([&] () {
+				/* older content of other handles must not overwrite the range */
+				write_back().flush(_path.base(), seek_offset, len,
+				                   &*_write_buffer);
+
+				if (_write_buffer->write(src, len, seek_offset)) {
+					ret = len;
+					return;
+				}
+
+				/* keep the order of buffered and direct writes */
+				if (!_write_buffer->flush())
+					Genode::error("failed to write back '", _path, "'");
+
 				ret = Fuse::fuse()->op.write(_path.base(), src, len,
 				                             seek_offset, &_file_info);
 			});
-			return ret < 0 ? 0 : ret;
+			if (ret < 0)
+				return 0;
+
+			attr_cache().written(_path.base(), seek_offset + ret);
+			return ret;
 		}
 
 		void truncate(file_size_t size) override
 		{
 			int res = -1;
-			Libc::with_libc([&] () {
+			with_driver([&] () {
+				write_back().flush(_path.base());
+
 				res = Fuse::fuse()->op.ftruncate(_path.base(), size,
 				                                 &_file_info);
 				});
-			if (res == 0)
+			if (res == 0) {
+				attr_cache().truncated(_path.base(), size);
 				mark_as_updated();
+			}
 		}
 };
 
@@ -26,6 +26,7 @@
 #include <directory.h>
 #include <open_node.h>
 #include <util.h>
+#include <worker_pool.h>
 
 
 namespace Fuse_fs {
@@ -54,6 +55,11 @@ class Fuse_fs::Session_component : public Session_rpc_object
 
 		Signal_handler<Session_component> _process_packet_handler;
 
+		enum { MAX_JOBS = File_system::Session::TX_QUEUE_SIZE };
+
+		Job        _jobs[MAX_JOBS] { };
+		Completion _completion { };
+
 
 		/******************************
 		 ** Packet-stream processing **
@@ -118,10 +124,10 @@ class Fuse_fs::Session_component : public Session_rpc_object
 				break;
 
 			case Packet_descriptor::SYNC:
-				Libc::with_libc([&] () {
+				with_driver([&] () {
+					succeeded = write_back().sync();
 					Fuse::sync_fs();
 				});
-				succeeded = true;
 				break;
 			}
 
@@ -130,6 +136,71 @@ class Fuse_fs::Session_component : public Session_rpc_object
 			tx_sink()->acknowledge_packet(packet);
 		}
 
+		Job *_free_job()
+		{
+			for (unsigned i = 0; i < MAX_JOBS; ++i)
+				if (_jobs[i].state == Job::FREE)
+					return &_jobs[i];
+			return nullptr;
+		}
+
+		/**
+		 * Pass a READ or WRITE packet to the worker pool
+		 *
+		 * \return true if the packet is processed by a worker
+		 */
+		bool _submit_job(Packet_descriptor &packet, Open_node &open_node)
+		{
+			Worker_pool &pool = worker_pool();
+			Node        &node = open_node.node();
+
+			if (!pool.enabled())
+				return false;
+
+			switch (packet.operation()) {
+			case Packet_descriptor::READ:
+			case Packet_descriptor::WRITE:
+				break;
+			default:
+				/* keep the order of operations on the node */
+				pool.wait_idle(node);
+				return false;
+			}
+
+			void * const content = tx_sink()->packet_content(packet);
+			Job  * const job     = _free_job();
+
+			if (!content || packet.length() > packet.size() || !job)
+				return false;
+
+			job->packet     = packet;
+			job->node       = &node;
+			job->content    = (char *)content;
+			job->completion = &_completion;
+
+			pool.submit(*job);
+			return true;
+		}
+
+		/**
+		 * Acknowledge the packets of completed jobs
+		 */
+		void _acknowledge_jobs()
+		{
+			while (tx_sink()->ready_to_ack()) {
+				Job *job = worker_pool().completed(_completion);
+				if (!job)
+					return;
+
+				if (job->acknowledge) {
+					job->packet.length(job->result_length);
+					job->packet.succeeded(job->succeeded);
+					tx_sink()->acknowledge_packet(job->packet);
+				}
+				job->state = Job::FREE;
+			}
+		}
+
 		void _process_packet()
 		{
 			Packet_descriptor packet = tx_sink()->get_packet();
@@ -138,7 +209,8 @@ class Fuse_fs::Session_component : public Session_rpc_object
 			packet.succeeded(false);
 
 			auto process_packet_fn = [&] (Open_node &open_node) {
-				_process_packet_op(packet, open_node);
+				if (!_submit_job(packet, open_node))
+					_process_packet_op(packet, open_node);
 			};
 
 			try {
@@ -155,6 +227,8 @@ class Fuse_fs::Session_component : public Session_rpc_object
 		 */
 		void _process_packets()
 		{
+			_acknowledge_jobs();
+
 			while (tx_sink()->packet_avail()) {
 
 				/*
@@ -172,6 +246,10 @@ class Fuse_fs::Session_component : public Session_rpc_object
 				if (!tx_sink()->ready_to_ack())
 					return;
 
+				/* resume when a job completed */
+				if (worker_pool().enabled() && !_free_job())
+					return;
+
 				_process_packet();
 			}
 		}
@@ -207,6 +285,8 @@ class Fuse_fs::Session_component : public Session_rpc_object
 		{
 			_tx.sigh_packet_avail(_process_packet_handler);
 			_tx.sigh_ready_to_ack(_process_packet_handler);
+
+			_completion.sigh = _process_packet_handler;
 		}
 
 		/**
@@ -214,7 +294,10 @@ class Fuse_fs::Session_component : public Session_rpc_object
 		 */
 		~Session_component()
 		{
-			Libc::with_libc([&] () {
+			worker_pool().wait_idle(_completion);
+
+			with_driver([&] () {
+				write_back().flush_all();
 				Fuse::sync_fs();
 			});
 
@@ -331,6 +414,7 @@ class Fuse_fs::Session_component : public Session_rpc_object
 		{
 			auto close_fn = [&] (Open_node &open_node) {
 				Node &node = open_node.node();
+				worker_pool().wait_idle(node);
 				destroy(_md_alloc, &open_node);
 				destroy(_md_alloc, &node);
 			};
@@ -380,16 +464,15 @@ class Fuse_fs::Session_component : public Session_rpc_object
 				}
 
 				struct stat s;
-				int res = -1;
-				/* XXX remove direct use of FUSE operations */
-				Libc::with_libc([&] () {
-					res = Fuse::fuse()->op.getattr(absolute_path.base(), &s);
-				});
+				int res = attr_cache().getattr(absolute_path.base(), s);
 				if (res != 0)
 					throw Lookup_failed();
 
 				/* XXX remove direct use of FUSE operations */
-				Libc::with_libc([&] () {
+				with_driver([&] () {
+					/* buffered content is written by path */
+					write_back().flush_all();
+
 					if (S_ISDIR(s.st_mode))
 						res = Fuse::fuse()->op.rmdir(absolute_path.base());
 					else
@@ -400,6 +483,9 @@ class Fuse_fs::Session_component : public Session_rpc_object
 					Genode::error("fuse()->op.unlink() returned unexpected error code: ", res);
 					return;
 				}
+
+				Dir_cache::namespace_changed();
+				attr_cache().invalidate_all();
 			};
 
 			try {
@@ -454,7 +540,8 @@ class Fuse_fs::Session_component : public Session_rpc_object
 
 					/* XXX remove direct use of FUSE operations */
 					int res = -1;
-					Libc::with_libc([&] () {
+					with_driver([&] () {
+						write_back().flush_all();
 						res = Fuse::fuse()->op.rename(absolute_from_path.base(),
 						                              absolute_to_path.base());
 					});
@@ -463,6 +550,9 @@ class Fuse_fs::Session_component : public Session_rpc_object
 						Genode::error("fuse()->op.rename() returned unexpected error code: ", res);
 						return;
 					}
+
+					Dir_cache::namespace_changed();
+					attr_cache().invalidate_all();
 				};
 
 				try {
@@ -487,8 +577,8 @@ class Fuse_fs::Root : public Root_component<Session_component>
 {
 	private:
 
-		Genode::Env                   &_env;
-		Genode::Attached_rom_dataspace _config { _env, "config" };
+		Genode::Env                    &_env;
+		Genode::Attached_rom_dataspace &_config;
 
 		Create_result _create(const char *args, Genode::Node const &policy)
 		{
@@ -569,30 +659,65 @@ class Fuse_fs::Root : public Root_component<Session_component>
 		 *
 		 * \param env         environment
 		 * \param md_alloc    meta-data allocator
+		 * \param config      component configuration
 		 */
-		Root(Genode::Env & env, Allocator &md_alloc)
+		Root(Genode::Env & env, Allocator &md_alloc,
+		     Genode::Attached_rom_dataspace &config)
 		: Root_component<Session_component>(env.ep(), md_alloc),
-		  _env(env) { }
+		  _env(env), _config(config) { }
 };
 
 
 extern "C" void wait_for_continue(void);
 
 
+static Genode::Constructible<Fuse_fs::Attr_cache> _attr_cache;
+
+Fuse_fs::Attr_cache &Fuse_fs::attr_cache() { return *_attr_cache; }
+
+
+static Genode::Constructible<Fuse_fs::Write_back> _write_back;
+
+Fuse_fs::Write_back &Fuse_fs::write_back() { return *_write_back; }
+
+
+static Genode::Constructible<Fuse_fs::Worker_pool> _worker_pool;
+
+Fuse_fs::Worker_pool &Fuse_fs::worker_pool() { return *_worker_pool; }
+
+
 struct Fuse_fs::Main
 {
-	Genode::Env & env;
-	Sliced_heap   sliced_heap { env.ram(), env.rm() };
-	Root          fs_root     { env, sliced_heap    };
+	Genode::Env                   & env;
+	Genode::Attached_rom_dataspace  config      { env, "config" };
+	Sliced_heap                     sliced_heap { env.ram(), env.rm() };
+	Root                            fs_root     { env, sliced_heap, config };
 
 	Main(Genode::Env & env) : env(env)
 	{
+		/* attributes are cached for one second by default */
+		_attr_cache.construct(env,
+			config.node().attribute_value("attr_ttl_ms", Genode::uint64_t(1000)));
+
+		unsigned const workers =
+			config.node().attribute_value("workers", 2U);
+
+		_write_back.construct(
+			config.node().attribute_value("write_policy", String<16>("write_back"))
+				!= "write_through",
+			config.node().attribute_value("write_buffer", Number_of_bytes(256*1024)),
+			config.node().attribute_value("write_buffer_limit", Number_of_bytes(8*1024*1024)));
+
 		bool success = false;
 		Libc::with_libc([&] () {
+			Driver_access::init();
+
 			if (!Fuse::init_fs()) {
 				Genode::error("FUSE fs initialization failed");
 				return;
 			}
+
+			_worker_pool.construct(workers);
 			success = true;
 		});
 		if (!success)
@@ -605,6 +730,7 @@ struct Fuse_fs::Main
 	{
 		if (Fuse::initialized()) {
 			Libc::with_libc([&] () {
+				write_back().flush_all();
 				Fuse::deinit_fs();
 			});
 		}
@@ -41,6 +41,12 @@ class Fuse_fs::Node : public Node_base
 
 	public:
 
+		/*
+		 * Packet jobs of the node, protected by the worker-pool mutex
+		 */
+		unsigned pending_jobs = 0;
+		bool     job_running  = false;
+
 		Node(char const *name) : _name(name) { }
 
 		char   const *name()  const { return _name.base(); }
@@ -17,6 +17,9 @@
 #define _SYMLINK_H_
 
 /* local includes */
+#include <attr_cache.h>
+#include <dir_cache.h>
+#include <driver.h>
 #include <node.h>
 
 
@@ -36,11 +39,7 @@ class Fuse_fs::Symlink : public Node
 		size_t _length() const
 		{
 			struct stat s;
-			int res = -1;
-			Libc::with_libc([&] () {
-				res = Fuse::fuse()->op.getattr(_path.base(), &s);
-			});
-			if (res != 0)
+			if (attr_cache().getattr(_path.base(), s) != 0)
 				return 0;
 
 			return s.st_size;
@@ -58,11 +57,7 @@ class Fuse_fs::Symlink : public Node
 		Status status() override
 		{
 			struct stat s;
-			int res = -1;
-			Libc::with_libc([&] () {
-				res = Fuse::fuse()->op.getattr(_path.base(), &s);
-			});
-			if (res != 0)
+			if (attr_cache().getattr(_path.base(), s) != 0)
 				return Status();
 
 			Status status;
@@ -75,7 +70,7 @@ class Fuse_fs::Symlink : public Node
 		size_t read(char *dst, size_t len, seek_off_t seek_offset) override
 		{
 			int res = -1;
-			Libc::with_libc([&] () {
+			with_driver([&] () {
 				res = Fuse::fuse()->op.readlink(_path.base(), dst, len);
 			});
 			if (res != 0)
@@ -90,12 +85,14 @@ class Fuse_fs::Symlink : public Node
 			if (seek_offset) return 0;
 
 			int res = -1;
-			Libc::with_libc([&] () {
+			with_driver([&] () {
 				res = Fuse::fuse()->op.symlink(src, _path.base());
 			});
 			if (res != 0)
 				return 0;
 
+			Dir_cache::namespace_changed();
+
 			return len;
 		}
 
@@ -0,0 +1,306 @@
+/*
+ * \brief  Pool of threads that process packet operations
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _WORKER_POOL_H_
+#define _WORKER_POOL_H_
+
+/* Genode includes */
+#include <base/mutex.h>
+#include <base/semaphore.h>
+#include <base/signal.h>
+#include <file_system_session/file_system_session.h>
+#include <libc/component.h>
+#include <util/fifo.h>
+
+/* libc includes */
+#include <pthread.h>
+
+/* local includes */
+#include <node.h>
+
+namespace Fuse_fs {
+	struct Job;
+	struct Completion;
+	class Worker_pool;
+
+	/**
+	 * Worker pool of the component
+	 */
+	Worker_pool &worker_pool();
+}
+
+
+/**
+ * READ or WRITE packet that is processed by a worker
+ *
+ * Jobs are owned by a session and only the entrypoint accesses the
+ * packet stream, workers access the packet content.
+ */
+struct Fuse_fs::Job : Genode::Fifo<Job>::Element
+{
+	enum State { FREE, QUEUED, RUNNING, COMPLETE };
+
+	State state = FREE;
+
+	File_system::Packet_descriptor packet { };
+
+	Node       *node       = nullptr;
+	char       *content    = nullptr;
+	Completion *completion = nullptr;
+
+	size_t result_length = 0;
+	bool   succeeded     = false;
+	bool   acknowledge   = true;
+};
+
+
+/**
+ * Completed jobs of a session, acknowledged by the entrypoint
+ */
+struct Fuse_fs::Completion
+{
+	Genode::Fifo<Job> jobs { };
+
+	Genode::Signal_context_capability sigh { };
+
+	/* number of queued or running jobs */
+	unsigned in_flight = 0;
+};
+
+
+/**
+ * Threads that execute jobs
+ *
+ * The jobs of one node are executed one at a time and in the order of
+ * submission, jobs of different nodes are executed concurrently. The
+ * FUSE driver itself is still entered by one thread at a time, see
+ * 'with_driver', but a job that waits for the block device no longer
+ * stalls the entrypoint and with it the RPC interface of all sessions.
+ */
+class Fuse_fs::Worker_pool
+{
+	public:
+
+		enum { MAX_WORKERS = 8 };
+
+	private:
+
+		Worker_pool(Worker_pool const &);
+		Worker_pool &operator = (Worker_pool const &);
+
+		/* protects the job queues and counters */
+		Genode::Mutex _mutex { };
+
+		/* wakes workers when jobs are queued */
+		Genode::Semaphore _queued_sem { };
+
+		/* wakes the entrypoint in libc context when jobs complete */
+		pthread_mutex_t _idle_mutex;
+		pthread_cond_t  _idle_cond;
+
+		Genode::Fifo<Job> _queued { };
+
+		unsigned  _count = 0;
+		pthread_t _threads[MAX_WORKERS];
+
+		/**
+		 * Dequeue the first job whose node is not busy
+		 */
+		Job *_next_runnable()
+		{
+			Job *runnable = nullptr;
+			_queued.for_each([&] (Job &job) {
+				if (!runnable && !job.node->job_running)
+					runnable = &job; });
+
+			if (runnable)
+				_queued.remove(*runnable);
+			return runnable;
+		}
+
+		static void _execute(Job &job)
+		{
+			size_t const length = job.packet.length();
+
+			switch (job.packet.operation()) {
+
+			case File_system::Packet_descriptor::READ:
+				job.result_length = job.node->read(job.content, length,
+				                                   job.packet.position());
+				job.succeeded = true;
+				break;
+
+			case File_system::Packet_descriptor::WRITE:
+				job.result_length = job.node->write(job.content, length,
+				                                    job.packet.position());
+
+				/* File system session can't handle partial writes */
+				if (job.result_length != length) {
+					Genode::error("partial write detected ",
+					              job.result_length, " vs ", length);
+					/* don't acknowledge */
+					job.acknowledge = false;
+					break;
+				}
+				job.succeeded = true;
+				break;
+
+			default:
+				break;
+			}
+		}
+
+		/*
+		 * A worker that finds no runnable job waits for the next
+		 * submission. Jobs held back because their node was busy are
+		 * picked up by the worker that completes the busy job, as it
+		 * checks the queue before waiting.
+		 */
+		void _work()
+		{
+			for (;;) {
+				Job *job = nullptr;
+				{
+					Genode::Mutex::Guard guard(_mutex);
+					job = _next_runnable();
+					if (job) {
+						job->state = Job::RUNNING;
+						job->node->job_running = true;
+					}
+				}
+
+				if (!job) {
+					_queued_sem.down();
+					continue;
+				}
+
+				_execute(*job);
+
+				Genode::Signal_context_capability sigh;
+				{
+					Genode::Mutex::Guard guard(_mutex);
+					job->node->job_running = false;
+					job->node->pending_jobs--;
+					job->completion->in_flight--;
+					job->state = Job::COMPLETE;
+					job->completion->jobs.enqueue(*job);
+					sigh = job->completion->sigh;
+				}
+
+				Genode::Signal_transmitter(sigh).submit();
+
+				pthread_mutex_lock(&_idle_mutex);
+				pthread_cond_broadcast(&_idle_cond);
+				pthread_mutex_unlock(&_idle_mutex);
+			}
+		}
+
+		static void *_entry(void *arg)
+		{
+			((Worker_pool *)arg)->_work();
+			return nullptr;
+		}
+
+		template <typename COND>
+		void _wait(COND const &cond)
+		{
+			if (!enabled())
+				return;
+
+			auto done = [&] () {
+				Genode::Mutex::Guard guard(_mutex);
+				return !cond();
+			};
+
+			Libc::with_libc([&] () {
+				pthread_mutex_lock(&_idle_mutex);
+				while (!done())
+					pthread_cond_wait(&_idle_cond, &_idle_mutex);
+				pthread_mutex_unlock(&_idle_mutex);
+			});
+		}
+
+	public:
+
+		/**
+		 * Constructor, must be called in libc context
+		 *
+		 * \param count  number of worker threads, with no workers the
+		 *               entrypoint processes all packets
+		 */
+		Worker_pool(unsigned count)
+		{
+			pthread_mutex_init(&_idle_mutex, nullptr);
+			pthread_cond_init(&_idle_cond, nullptr);
+
+			pthread_attr_t attr;
+			pthread_attr_init(&attr);
+			pthread_attr_setstacksize(&attr, 512*1024);
+
+			for (unsigned i = 0; i < Genode::min(count, (unsigned)MAX_WORKERS); ++i) {
+				if (pthread_create(&_threads[i], &attr, _entry, this) != 0) {
+					Genode::error("failed to create worker thread");
+					break;
+				}
+				++_count;
+			}
+
+			pthread_attr_destroy(&attr);
+		}
+
+		bool enabled() const { return _count > 0; }
+
+		/**
+		 * Queue a job, called by the entrypoint
+		 */
+		void submit(Job &job)
+		{
+			Genode::Mutex::Guard guard(_mutex);
+
+			job.state         = Job::QUEUED;
+			job.result_length = 0;
+			job.succeeded     = false;
+			job.acknowledge   = true;
+			job.node->pending_jobs++;
+			job.completion->in_flight++;
+
+			_queued.enqueue(job);
+			_queued_sem.up();
+		}
+
+		/**
+		 * Dequeue a completed job, in order of completion
+		 */
+		Job *completed(Completion &completion)
+		{
+			Genode::Mutex::Guard guard(_mutex);
+
+			Job *job = nullptr;
+			completion.jobs.dequeue([&] (Job &j) { job = &j; });
+			return job;
+		}
+
+		/**
+		 * Wait until no job of a node is queued or running
+		 */
+		void wait_idle(Node &node) {
+			_wait([&] () { return node.pending_jobs > 0; }); }
+
+		/**
+		 * Wait until no job of a session is queued or running
+		 */
+		void wait_idle(Completion &completion) {
+			_wait([&] () { return completion.in_flight > 0; }); }
+};
+
+#endif /* _WORKER_POOL_H_ */
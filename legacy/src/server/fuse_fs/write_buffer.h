@@ -0,0 +1,305 @@
+/*
+ * \brief  Write-back buffering of file content
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _WRITE_BUFFER_H_
+#define _WRITE_BUFFER_H_
+
+/* Genode includes */
+#include <base/log.h>
+#include <util/list.h>
+#include <util/misc_math.h>
+#include <util/reconstructible.h>
+#include <util/string.h>
+
+/* libc includes */
+#include <stdlib.h>
+
+#include <fuse.h>
+#include <fuse_private.h>
+
+namespace Fuse_fs {
+	class Write_buffer;
+	class Write_back;
+
+	/**
+	 * Write-back state of the component
+	 */
+	Write_back &write_back();
+}
+
+
+/**
+ * Extent of written but not yet flushed content of an open file
+ *
+ * Writes that are adjacent to or overlap the extent are merged into it,
+ * so a sequence of small writes reaches the FUSE driver as one large
+ * write. The extent is flushed when a write does not fit, before any
+ * handle of the file reads or writes the buffered range or truncates the
+ * file, when the file is closed, and on SYNC.
+ *
+ * All operations must be called while holding the driver, see
+ * 'with_driver', which also serializes the buffers of different files.
+ */
+class Fuse_fs::Write_buffer : public Genode::List<Write_buffer>::Element
+{
+	private:
+
+		Write_buffer(Write_buffer const &);
+		Write_buffer &operator = (Write_buffer const &);
+
+		char const            *_path;
+		struct fuse_file_info &_file_info;
+
+		char             *_data   = nullptr;
+		Genode::uint64_t  _offset = 0;
+		Genode::size_t    _length = 0;
+
+		bool _write_to_driver(char const *src, Genode::size_t len,
+		                      Genode::uint64_t offset)
+		{
+			while (len) {
+				int const ret = Fuse::fuse()->op.write(_path, src, len, offset,
+				                                       &_file_info);
+				if (ret <= 0)
+					return false;
+
+				src    += ret;
+				len    -= ret;
+				offset += ret;
+			}
+			return true;
+		}
+
+	public:
+
+		inline Write_buffer(char const *path, struct fuse_file_info &file_info);
+
+		inline ~Write_buffer();
+
+		bool empty() const { return _length == 0; }
+
+		Genode::uint64_t end() const { return _offset + _length; }
+
+		bool overlaps(Genode::uint64_t offset, Genode::size_t len) const {
+			return !empty() && offset < end() && offset + len > _offset; }
+
+		bool buffers(char const *path) const {
+			return !empty() && Genode::strcmp(_path, path) == 0; }
+
+		/**
+		 * Buffer a write
+		 *
+		 * \return false if the write must be passed to the driver
+		 */
+		inline bool write(char const *src, Genode::size_t len,
+		                  Genode::uint64_t offset);
+
+		/**
+		 * Pass the buffered extent to the driver and release the buffer
+		 *
+		 * A failure is also recorded for the next SYNC, see 'Write_back'.
+		 *
+		 * \return false if the driver failed to write the extent
+		 */
+		inline bool flush();
+};
+
+
+/**
+ * Policy and memory budget of the write buffers
+ *
+ * A buffer is allocated when a file is written and released when it is
+ * flushed. If the buffers of all files exceed the budget, all buffers are
+ * flushed before another one is allocated.
+ */
+class Fuse_fs::Write_back
+{
+	private:
+
+		friend class Write_buffer;
+
+		Genode::List<Write_buffer> _buffers { };
+
+		bool           const _enabled;
+		Genode::size_t const _buffer_size;
+		Genode::size_t const _limit;
+
+		Genode::size_t _allocated = 0;
+
+		/* a flush failed since the last 'sync' */
+		bool _failed = false;
+
+		char *_alloc()
+		{
+			if (_allocated + _buffer_size > _limit)
+				flush_all();
+
+			if (_allocated + _buffer_size > _limit)
+				return nullptr;
+
+			char *data = (char *)::malloc(_buffer_size);
+			if (data)
+				_allocated += _buffer_size;
+			return data;
+		}
+
+		void _free(char *data)
+		{
+			::free(data);
+			_allocated -= _buffer_size;
+		}
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param enabled      write-back, or write-through if false
+		 * \param buffer_size  size of the buffer of a file
+		 * \param limit        size of all buffers
+		 */
+		Write_back(bool enabled, Genode::size_t buffer_size, Genode::size_t limit)
+		:
+			_enabled(enabled && buffer_size && limit >= buffer_size),
+			_buffer_size(buffer_size), _limit(limit)
+		{ }
+
+		bool enabled() const { return _enabled; }
+
+		Genode::size_t buffer_size() const { return _buffer_size; }
+
+		/**
+		 * Flush the buffers of all files, must hold the driver
+		 */
+		void flush_all()
+		{
+			for (Write_buffer *b = _buffers.first(); b; b = b->next())
+				b->flush();
+		}
+
+		/**
+		 * Flush the buffers of all handles of a file, must hold the driver
+		 *
+		 * The buffers of other handles are flushed as well, so that
+		 * a read or truncation through any handle sees all writes.
+		 */
+		void flush(char const *path)
+		{
+			for (Write_buffer *b = _buffers.first(); b; b = b->next())
+				if (b->buffers(path))
+					b->flush();
+		}
+
+		/**
+		 * Flush the buffers of all handles that overlap a range of a file,
+		 * must hold the driver
+		 *
+		 * \param except  buffer of the calling handle that is kept
+		 */
+		void flush(char const *path, Genode::uint64_t offset, Genode::size_t len,
+		           Write_buffer const *except = nullptr)
+		{
+			for (Write_buffer *b = _buffers.first(); b; b = b->next())
+				if (b != except && b->buffers(path) && b->overlaps(offset, len))
+					b->flush();
+		}
+
+		/**
+		 * Flush the buffers of all files on SYNC, must hold the driver
+		 *
+		 * \return false if a flush failed since the last call
+		 */
+		bool sync()
+		{
+			flush_all();
+
+			bool const succeeded = !_failed;
+			_failed = false;
+			return succeeded;
+		}
+};
+
+
+Fuse_fs::Write_buffer::Write_buffer(char const *path,
+                                    struct fuse_file_info &file_info)
+:
+	_path(path), _file_info(file_info)
+{
+	write_back()._buffers.insert(this);
+}
+
+
+Fuse_fs::Write_buffer::~Write_buffer()
+{
+	if (!flush())
+		Genode::error("failed to write back '", _path, "'");
+
+	write_back()._buffers.remove(this);
+}
+
+
+bool Fuse_fs::Write_buffer::write(char const *src, Genode::size_t len,
+                                  Genode::uint64_t offset)
+{
+	Write_back &policy = write_back();
+
+	if (!policy.enabled())
+		return false;
+
+	/* merge with the extent if adjacent or overlapping */
+	bool const mergeable = !empty()
+	                    && offset >= _offset && offset <= end()
+	                    && offset + len <= _offset + policy.buffer_size();
+
+	if (!mergeable)
+		flush();
+
+	/* large writes are efficient already */
+	if (len >= policy.buffer_size())
+		return false;
+
+	if (!_data) {
+		_data = policy._alloc();
+		if (!_data)
+			return false;
+	}
+
+	if (empty())
+		_offset = offset;
+
+	Genode::memcpy(_data + (offset - _offset), src, len);
+	_length = Genode::max(_length, Genode::size_t(offset + len - _offset));
+
+	if (_length == policy.buffer_size())
+		flush();
+
+	return true;
+}
+
+
+bool Fuse_fs::Write_buffer::flush()
+{
+	bool const succeeded = empty() || _write_to_driver(_data, _length, _offset);
+
+	if (!succeeded)
+		write_back()._failed = true;
+
+	if (_data)
+		write_back()._free(_data);
+
+	_data   = nullptr;
+	_length = 0;
+	return succeeded;
+}
+
+#endif /* _WRITE_BUFFER_H_ */
@@ -253,6 +253,7 @@ void Ssh::Server::_parse_config(Genode::Node const &config)
 	_verbose    = config.attribute_value("verbose",    false);
 	_log_level  = config.attribute_value("debug",      0u);
 	_log_logins = config.attribute_value("log_logins", true);
+	_sftp_sync  = config.attribute_value("sftp_sync",  false);
 
 	{
 		Util::Pthread_mutex::Guard guard(_logins.mutex());
@@ -510,7 +511,7 @@ void Ssh::Server::incoming_connection(ssh_session s)
 	 * which would lead to a deadlock.
 	 */
 	new (&_heap) Session(_env, _heap, _new_sessions, _signaller, s,
-	                     &_channel_cb, ++_session_id);
+	                     &_channel_cb, ++_session_id, _sftp_sync);
 }
 
 
@@ -717,7 +718,8 @@ void Ssh::Server::loop()
 			                     _signaller,
 			                     inactive_session.session,
 			                     inactive_session.channel_cb,
-			                     inactive_session.id());
+			                     inactive_session.id(),
+			                     _sftp_sync);
 
 			ssh_session s = inactive_session.session;
 
@@ -74,9 +74,10 @@ struct Ssh::Session : Genode::Registry<Session>::Element
 	        Wake_up_signaller &wake_up_signaller,
 	        ssh_session s,
 	        ssh_channel_callbacks ccb,
-	        uint32_t id)
+	        uint32_t id,
+	        bool sftp_sync_on_close)
 	: Element(reg, *this), _heap(heap), _id(id), session(s), channel_cb(ccb),
-	  sftp(heap, wake_up_signaller)
+	  sftp(heap, wake_up_signaller, sftp_sync_on_close)
 	{
 		ssh_set_blocking(s, false);
 	}
@@ -159,6 +160,7 @@ class Ssh::Server
 		bool           _allow_password    { false };
 		bool           _allow_publickey   { false };
 		bool           _log_logins        { false };
+		bool           _sftp_sync         { false };
 		int            _max_auth_attempts { 3 };
 		unsigned       _port              { 0u };
 		unsigned       _log_level         { 0u };
@@ -20,6 +20,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <fcntl.h>
+#include <unistd.h>
 
 extern "C" {
 #include <libssh/buffer.h>
@@ -55,9 +56,15 @@ void * Ssh::Sftp::sftp_worker_loop(void *arg)
 {
 	Ssh::Sftp &server = *reinterpret_cast<Ssh::Sftp*>(arg);
 
+	server.start_workers();
+
 	bool signal_sent = false;
+	sftp_client_message next = nullptr;
+	bool next_dequeued = false;
 	while (true) {
-		sftp_client_message msg = server._client_requests.get();
+		sftp_client_message msg = next_dequeued
+		                        ? next : server._client_requests.get();
+		next_dequeued = false;
 
 		/* made some place in _client_requests so signal about it */
 		if (!signal_sent) {
@@ -68,9 +75,21 @@ void * Ssh::Sftp::sftp_worker_loop(void *arg)
 		/* exit loop if empty message found */
 		if (msg == NULL) break;
 
-		server.process_message(msg);
+		Job &job = server.alloc_job();
+		job.msgs[0] = msg;
+		job.count   = 1;
+		job.key     = msg->handle ? server.lookup_handle(msg->handle) : nullptr;
+
+		/* reads and writes are batched with those queued behind them */
+		if (msg->type == SFTP_READ || msg->type == SFTP_WRITE)
+			next_dequeued = server.collect_batch(job, next);
+
+		server.queue_job(job);
 	}
 
+	/* complete the requests received before the end of communication */
+	server.stop_workers();
+
 	ssh_channel_request_send_exit_status(server._sftp_server->channel, 0);
 
 	server.set_state(WORKER_FINISHED);
@@ -81,6 +100,183 @@ void * Ssh::Sftp::sftp_worker_loop(void *arg)
 }
 
 
+void * Ssh::Sftp::sftp_job_loop(void *arg)
+{
+	Ssh::Sftp &server = *reinterpret_cast<Ssh::Sftp*>(arg);
+
+	pthread_mutex_lock(&server._jobs_mutex);
+	while (true) {
+		Job *job = server.next_runnable_job();
+		if (job == nullptr) {
+			if (server._stopping && server._queued_jobs.empty()) break;
+			pthread_cond_wait(&server._jobs_cond, &server._jobs_mutex);
+			continue;
+		}
+
+		job->running = true;
+		server._running_jobs++;
+		pthread_mutex_unlock(&server._jobs_mutex);
+
+		server.execute_job(*job);
+
+		pthread_mutex_lock(&server._jobs_mutex);
+		job->running = false;
+		job->key     = nullptr;
+		server._running_jobs--;
+		server._job_requests -= job->count;
+		server._free_jobs.enqueue(*job);
+
+		/* wake the dispatcher and workers waiting for the handle */
+		pthread_cond_broadcast(&server._jobs_cond);
+	}
+	pthread_mutex_unlock(&server._jobs_mutex);
+
+	return 0;
+}
+
+
+void Ssh::Sftp::start_workers()
+{
+	for (unsigned i = 0; i < WORKERS; i++) {
+		if (pthread_create(&_workers[i], nullptr,
+		                   Ssh::Sftp::sftp_job_loop, (void*) this) != 0) {
+			Genode::error("sftp: pthread_create for worker failed");
+			break;
+		}
+		_num_workers++;
+	}
+
+	/* without workers, jobs are executed by the dispatcher */
+	if (_num_workers == 0)
+		Genode::warning("sftp: executing requests sequentially");
+}
+
+
+void Ssh::Sftp::stop_workers()
+{
+	pthread_mutex_lock(&_jobs_mutex);
+	_stopping = true;
+	pthread_cond_broadcast(&_jobs_cond);
+	pthread_mutex_unlock(&_jobs_mutex);
+
+	for (unsigned i = 0; i < _num_workers; i++)
+		pthread_join(_workers[i], nullptr);
+
+	_num_workers = 0;
+}
+
+
+/*
+ * Blocks until a job is free and the replies of a batch of requests fit
+ * into '_pending_packets' in addition to the replies that are queued or
+ * produced by the queued and running jobs. The dispatcher thus stops
+ * taking requests while the channel window is closed.
+ */
+Ssh::Sftp::Job &Ssh::Sftp::alloc_job()
+{
+	Job *job = nullptr;
+
+	auto replies_fit = [&] () {
+		return _closing || _job_requests + _queued_replies + READ_BATCH_MAX
+		                   <= PENDING_REPLIES_MAX; };
+
+	pthread_mutex_lock(&_jobs_mutex);
+	while (job == nullptr) {
+		if (replies_fit())
+			_free_jobs.dequeue([&] (Job &j) { job = &j; });
+		if (job == nullptr)
+			pthread_cond_wait(&_jobs_cond, &_jobs_mutex);
+	}
+	pthread_mutex_unlock(&_jobs_mutex);
+
+	return *job;
+}
+
+
+void Ssh::Sftp::queue_job(Job &job)
+{
+	if (_num_workers == 0) {
+		execute_job(job);
+		pthread_mutex_lock(&_jobs_mutex);
+		_free_jobs.enqueue(job);
+		pthread_mutex_unlock(&_jobs_mutex);
+		return;
+	}
+
+	pthread_mutex_lock(&_jobs_mutex);
+	_job_requests += job.count;
+	_queued_jobs.enqueue(job);
+	pthread_cond_broadcast(&_jobs_cond);
+	pthread_mutex_unlock(&_jobs_mutex);
+}
+
+
+/*
+ * Called with '_jobs_mutex' held. A job is skipped while a job on the
+ * same handle is running. As all queued jobs on that handle are skipped
+ * alike, the jobs of a handle are started in order of arrival.
+ */
+Ssh::Sftp::Job *Ssh::Sftp::next_runnable_job()
+{
+	auto busy = [&] (void const *key) {
+		if (key == nullptr) return false;
+		for (Job const &job : _jobs)
+			if (job.running && job.key == key) return true;
+		return false;
+	};
+
+	Job *runnable = nullptr;
+	_queued_jobs.for_each([&] (Job &job) {
+		if (runnable == nullptr && !busy(job.key))
+			runnable = &job; });
+
+	if (runnable != nullptr)
+		_queued_jobs.remove(*runnable);
+
+	return runnable;
+}
+
+
+void Ssh::Sftp::execute_job(Job &job)
+{
+	uint8_t const type = job.msgs[0]->type;
+
+	if (type == SFTP_READ || type == SFTP_WRITE) {
+		if (type == SFTP_READ)
+			process_read(job.msgs, job.count);
+		else
+			process_write(job.msgs, job.count);
+
+		for (unsigned i = 0; i < job.count; i++)
+			sftp_client_message_free(job.msgs[i]);
+	} else {
+		process_message(job.msgs[0]);
+	}
+	job.count = 0;
+}
+
+
+Ssh::Sftp::Handle* Ssh::Sftp::lookup_handle(ssh_string handle)
+{
+	Genode::Mutex::Guard guard(_handle_table_mutex);
+	return reinterpret_cast<Handle*>(sftp_handle(_sftp_server, handle));
+}
+
+
+ssh_string Ssh::Sftp::alloc_handle(Handle* handle)
+{
+	Genode::Mutex::Guard guard(_handle_table_mutex);
+	return sftp_handle_alloc(_sftp_server, handle);
+}
+
+
+void Ssh::Sftp::remove_handle(ssh_string handle)
+{
+	Genode::Mutex::Guard guard(_handle_table_mutex);
+	sftp_handle_remove(_sftp_server, handle);
+}
+
+
 Ssh::Sftp::~Sftp()
 {
 	cleanup();
@@ -250,6 +446,12 @@ int Ssh::Sftp::incoming_sftp_data(void *data, uint32_t len)
 
 void Ssh::Sftp::handle_eof()
 {
+	/* release the dispatcher if it waits for replies to be sent */
+	pthread_mutex_lock(&_jobs_mutex);
+	_closing = true;
+	pthread_cond_broadcast(&_jobs_cond);
+	pthread_mutex_unlock(&_jobs_mutex);
+
 	set_state(WORKER_CLOSING);
 	enqueue_sftp_client_message(0);
 }
@@ -408,7 +610,22 @@ int Ssh::Sftp::enqueue_sftp_packet(ssh_buffer payload)
 	/* cannot just take buffer as it is released by caller */
 	ssh_buffer_swap(payload, buf);
 
-	_pending_packets.add(buf);
+	/* the queue is only exhausted after the end of communication */
+	pthread_mutex_lock(&_jobs_mutex);
+	bool const full = (_queued_replies == PENDING_REPLIES_MAX);
+	if (!full)
+		_queued_replies++;
+	pthread_mutex_unlock(&_jobs_mutex);
+
+	if (full) {
+		ssh_buffer_free(buf);
+		return SSH_ERROR;
+	}
+
+	{
+		Genode::Mutex::Guard guard(_pending_packets_mutex);
+		_pending_packets.add(buf);
+	}
 
 	_wake_up_signaller.signal_wake_up();
 
@@ -431,6 +648,12 @@ void Ssh::Sftp::send_queued_packets(ssh_channel channel)
 		} else {
 			payload = _pending_packets.get();
 
+			/* let the dispatcher take further requests */
+			pthread_mutex_lock(&_jobs_mutex);
+			_queued_replies--;
+			pthread_cond_broadcast(&_jobs_cond);
+			pthread_mutex_unlock(&_jobs_mutex);
+
 			/* made some place in _pending_packets so signal about it */
 			if (!signal_sent) {
 				signal_sent = true;
@@ -482,20 +705,61 @@ int Ssh::Sftp::Handle::close_dir()
 	return result;
 }
 
-int Ssh::Sftp::Handle::close_file()
+int Ssh::Sftp::Handle::close_file(bool sync)
 {
-	if (_file == nullptr) return -1;
+	if (_fd < 0) return -1;
 
-	int result = fclose(_file);
-	if (result != 0) {
+	/* one sync per file instead of one per write */
+	int result = (sync && _written) ? fsync(_fd) : 0;
+
+	if (::close(_fd) != 0) {
 		Genode::error("close_file(): failed to close file");
+		result = -1;
 	}
-	_file = nullptr;
+	_fd = -1;
 
 	return result;
 }
 
 
+char *Ssh::Sftp::Handle::buffer(size_t size)
+{
+	if (size <= _buffer_size) return _buffer;
+
+	char *buffer = reinterpret_cast<char*>(::realloc(_buffer, size));
+	if (buffer == nullptr) return nullptr;
+
+	_buffer      = buffer;
+	_buffer_size = size;
+	return _buffer;
+}
+
+ssize_t Ssh::Sftp::Handle::read(char *dst, size_t len, off_t offset)
+{
+	size_t done = 0;
+	while (done < len) {
+		ssize_t const n = pread(_fd, dst + done, len - done, offset + done);
+		if (n < 0) return done ? (ssize_t)done : -1;
+		if (n == 0) break;
+		done += n;
+	}
+	return done;
+}
+
+ssize_t Ssh::Sftp::Handle::write(char const *src, size_t len, off_t offset)
+{
+	_written = true;
+
+	size_t done = 0;
+	while (done < len) {
+		ssize_t const n = pwrite(_fd, src + done, len - done, offset + done);
+		if (n <= 0) return -1;
+		done += n;
+	}
+	return done;
+}
+
+
 int Ssh::Sftp::reply_errno_status(sftp_client_message msg)
 {
 	const int MAX_STRERROR = 1024;
@@ -594,11 +858,9 @@ void Ssh::Sftp::process_message(sftp_client_message msg)
 		process_realpath(msg, PROCESS);
 		break;
 	case SFTP_STAT:
-		Genode::log("received stat: ", (const char*) msg->filename);
 		process_stat(msg, STAT);
 		break;
 	case SFTP_LSTAT:
-		Genode::log("received lstat: ", (const char*) msg->filename);
 		process_stat(msg, LSTAT);
 		break;
 	case SFTP_OPENDIR:
@@ -609,21 +871,17 @@ void Ssh::Sftp::process_message(sftp_client_message msg)
 		Genode::log("received open: ", (const char*) msg->filename);
 		process_open(msg);
 		break;
+	/* operations on open handles are frequent and not logged */
 	case SFTP_READDIR:
-		Genode::log("received readdir");
 		process_readdir(msg);
 		break;
 	case SFTP_READ:
-		Genode::log("received read: offset=", msg->offset, ", len=", msg->len);
-		process_read(msg);
+		process_read(&msg, 1);
 		break;
 	case SFTP_WRITE:
-		Genode::log("received write: offset=", msg->offset, ", len=",
-		            ssh_string_len(msg->data));
-		process_write(msg);
+		process_write(&msg, 1);
 		break;
 	case SFTP_CLOSE:
-		Genode::log("received close");
 		process_close(msg);
 		break;
 	case SFTP_REMOVE:
@@ -729,7 +987,7 @@ void Ssh::Sftp::process_opendir(sftp_client_message msg)
 	}
 
 	Handle* handle = new (&_heap) Handle(dir, msg->filename, is_root, _handles);
-	ssh_string sftp_handle = sftp_handle_alloc(_sftp_server, handle);
+	ssh_string sftp_handle = alloc_handle(handle);
 	if (sftp_handle == nullptr) {
 		Genode::error("process_opendir(): failed to allocate handle");
 		return;
@@ -766,24 +1024,8 @@ void Ssh::Sftp::process_open(sftp_client_message msg)
 		return;
 	}
 
-	const char* fd_mode;
-	if (msg->flags & SSH_FXF_CREAT && msg->flags & SSH_FXF_APPEND)
-		fd_mode = (readwrite ? "a+" : "a");
-	else if (msg->flags & SSH_FXF_CREAT && msg->flags & SSH_FXF_TRUNC)
-		fd_mode = (readwrite ? "w+" : "w");
-	else
-		fd_mode = (readwrite ? "r+" : "r");
-
-	FILE* file = fdopen(fd, fd_mode);
-	if (file == nullptr) {
-		if (reply_errno_status(msg) != 0) {
-			Genode::error("process_open(): failed to reply errno status");
-		}
-		return;
-	}
-
-	Handle* handle = new (&_heap) Handle(file, msg->filename, _handles);
-	ssh_string sftp_handle = sftp_handle_alloc(_sftp_server, handle);
+	Handle* handle = new (&_heap) Handle(fd, msg->filename, _handles);
+	ssh_string sftp_handle = alloc_handle(handle);
 	if (sftp_handle == nullptr) {
 		Genode::error("process_open(): failed to allocate handle");
 		return;
@@ -796,8 +1038,7 @@ void Ssh::Sftp::process_open(sftp_client_message msg)
 
 void Ssh::Sftp::process_readdir(sftp_client_message msg)
 {
-	Handle* handle = reinterpret_cast<Handle*>(sftp_handle(_sftp_server,
-	                                                       msg->handle));
+	Handle* handle = lookup_handle(msg->handle);
 	if (handle == nullptr) {
 		Genode::error("process_readdir(): received invalid handle");
 		if (sftp_reply_status(msg, SSH_FX_INVALID_HANDLE, "invalid handle") != 0) {
@@ -884,106 +1125,166 @@ void Ssh::Sftp::process_readdir(sftp_client_message msg)
 	}
 }
 
-void Ssh::Sftp::process_read(sftp_client_message msg)
+/*
+ * Length of a read or write request as processed
+ */
+static size_t batch_len(sftp_client_message msg, uint32_t read_len_max)
+{
+	return msg->type == SFTP_READ ? Genode::min(msg->len, read_len_max)
+	                              : ssh_string_len(msg->data);
+}
+
+bool Ssh::Sftp::collect_batch(Job &job, sftp_client_message &next)
+{
+	sftp_client_message const msg = job.msgs[0];
+
+	size_t const max_bytes = msg->type == SFTP_READ ? READ_BATCH_BYTES
+	                                                : WRITE_BATCH_BYTES;
+
+	uint64_t end   = msg->offset + batch_len(msg, READ_LEN_MAX);
+	size_t   bytes = batch_len(msg, READ_LEN_MAX);
+
+	/*
+	 * Clients pipeline reads and writes of consecutive ranges, which
+	 * are collected as long as they are queued already
+	 */
+	while (job.count < READ_BATCH_MAX && !_client_requests.empty()) {
+		next = _client_requests.get();
+
+		if (next == nullptr
+		 || next->type != msg->type
+		 || next->offset != end
+		 || bytes + batch_len(next, READ_LEN_MAX) > max_bytes
+		 || lookup_handle(next->handle) != job.key)
+			return true;
+
+		size_t const len = batch_len(next, READ_LEN_MAX);
+
+		job.msgs[job.count++] = next;
+		end   += len;
+		bytes += len;
+	}
+	return false;
+}
+
+void Ssh::Sftp::process_read(sftp_client_message *msgs, unsigned count)
 {
-	Handle* handle = reinterpret_cast<Handle*>(sftp_handle(_sftp_server,
-	                                                       msg->handle));
+	/* reply the same status to all requests of the batch */
+	auto reply_status = [&] (uint32_t status, const char *message) {
+		for (unsigned i = 0; i < count; i++) {
+			if (sftp_reply_status(msgs[i], status, message) != 0) {
+				Genode::error("process_read(): failed to reply status");
+			}
+		}
+	};
+
+	Handle* handle = lookup_handle(msgs[0]->handle);
 	if (handle == nullptr) {
 		Genode::error("process_read(): received invalid handle");
-		if (sftp_reply_status(msg, SSH_FX_INVALID_HANDLE, "invalid handle") != 0) {
-			Genode::error("process_read(): failed to reply invalid handle status");
-		}
+		reply_status(SSH_FX_INVALID_HANDLE, "invalid handle");
 		return;
 	}
 	if (handle->_type != Handle::HFILE) {
 		Genode::error("process_read(): wrong handle type");
-		if (sftp_reply_status(msg, SSH_FX_BAD_MESSAGE, "wrong handle type") != 0) {
-			Genode::error("process_read(): ",
-			              "failed to reply wrong handle type status");
-		}
+		reply_status(SSH_FX_BAD_MESSAGE, "wrong handle type");
 		return;
 	}
 
-	if (fseeko(handle->_file, msg->offset, SEEK_SET) != 0) {
-		if (reply_errno_status(msg) != 0) {
-			Genode::error("process_read(): failed to reply errno status");
-		}
+	size_t len = 0;
+	for (unsigned i = 0; i < count; i++)
+		len += Genode::min(msgs[i]->len, READ_LEN_MAX);
+
+	char *data = handle->buffer(len);
+	if (data == nullptr) {
+		reply_status(SSH_FX_FAILURE, "memory allocation failed");
 		return;
 	}
 
-	constexpr int max_len = 2<<15; /* 32k */
-	uint32_t len = (msg->len > max_len ? max_len : msg->len);
-	void* data = malloc(len);
-	if (data == nullptr) {
-		if (sftp_reply_status(msg, SSH_FX_FAILURE,
-		                      "memory allocation failed") != 0) {
-			Genode::error("process_read(): ",
-			              "failed to reply memory allocation failed");
+	ssize_t const read_len = handle->read(data, len, msgs[0]->offset);
+	if (read_len < 0) {
+		for (unsigned i = 0; i < count; i++) {
+			if (reply_errno_status(msgs[i]) != 0) {
+				Genode::error("process_read(): failed to reply errno status");
+			}
 		}
 		return;
 	}
-	Free_guard data_guard(data);
 
-	size_t read_len = fread(data, 1, len, handle->_file);
-	Genode::log("process_read(): read ", read_len, " bytes");
-	if (read_len == 0) {
-		if (feof(handle->_file)) {
-			if (sftp_reply_status(msg, SSH_FX_EOF, nullptr) != 0) {
+	/* a short read ends the data of the batch */
+	size_t pos = 0;
+	for (unsigned i = 0; i < count; i++) {
+		size_t const msg_len = Genode::min(msgs[i]->len, READ_LEN_MAX);
+		size_t const avail   = (size_t)read_len > pos
+		                     ? Genode::min(msg_len, (size_t)read_len - pos) : 0;
+
+		if (avail == 0) {
+			if (sftp_reply_status(msgs[i], SSH_FX_EOF, nullptr) != 0) {
 				Genode::error("process_read(): failed to reply eof");
 			}
-			return;
-		}
-		if (reply_errno_status(msg) != 0) {
-			Genode::error("process_read(): failed to reply errno status");
+		} else if (sftp_reply_data(msgs[i], data + pos, avail) != 0) {
+			Genode::error("process_read(): failed to reply data");
 		}
-		return;
-	}
 
-	if (sftp_reply_data(msg, data, read_len) != 0) {
-		Genode::error("process_read(): failed to reply data");
+		pos += msg_len;
 	}
 }
 
-void Ssh::Sftp::process_write(sftp_client_message msg)
+void Ssh::Sftp::process_write(sftp_client_message *msgs, unsigned count)
 {
-	Handle* handle = reinterpret_cast<Handle*>(sftp_handle(_sftp_server,
-	                                                       msg->handle));
+	/* reply the same status to all requests of the batch */
+	auto reply_status = [&] (uint32_t status, const char *message) {
+		for (unsigned i = 0; i < count; i++) {
+			if (sftp_reply_status(msgs[i], status, message) != 0) {
+				Genode::error("process_write(): failed to reply status");
+			}
+		}
+	};
+
+	Handle* handle = lookup_handle(msgs[0]->handle);
 	if (handle == nullptr) {
 		Genode::error("process_write(): received invalid handle");
-		if (sftp_reply_status(msg, SSH_FX_INVALID_HANDLE, "invalid handle") != 0) {
-			Genode::error("process_write(): failed to reply invalid handle status");
-		}
+		reply_status(SSH_FX_INVALID_HANDLE, "invalid handle");
 		return;
 	}
 	if (handle->_type != Handle::HFILE) {
 		Genode::error("process_write(): wrong handle type");
-		if (sftp_reply_status(msg, SSH_FX_BAD_MESSAGE, "wrong handle type") != 0) {
-			Genode::error("process_write(): ",
-			              "failed to reply wrong handle type status");
-		}
+		reply_status(SSH_FX_BAD_MESSAGE, "wrong handle type");
 		return;
 	}
 
-	if (fseeko(handle->_file, msg->offset, SEEK_SET) != 0) {
-		if (reply_errno_status(msg) != 0) {
-			Genode::error("process_write(): failed to reply errno status");
+	/* a single request is written directly from the packet payload */
+	char const *data = reinterpret_cast<char const*>(ssh_string_data(msgs[0]->data));
+	size_t      len  = ssh_string_len(msgs[0]->data);
+
+	if (count > 1) {
+		for (unsigned i = 1; i < count; i++)
+			len += ssh_string_len(msgs[i]->data);
+
+		char *buffer = handle->buffer(len);
+		if (buffer == nullptr) {
+			reply_status(SSH_FX_FAILURE, "memory allocation failed");
+			return;
 		}
-		return;
+
+		size_t pos = 0;
+		for (unsigned i = 0; i < count; i++) {
+			size_t const msg_len = ssh_string_len(msgs[i]->data);
+			::memcpy(buffer + pos, ssh_string_data(msgs[i]->data), msg_len);
+			pos += msg_len;
+		}
+		data = buffer;
 	}
 
-	size_t data_len = ssh_string_len(msg->data);
-	size_t write_len = fwrite(ssh_string_data(msg->data), 1, data_len,
-	                          handle->_file);
-	if (write_len != data_len) {
-		if (reply_errno_status(msg) != 0) {
-			Genode::error("process_write(): failed to reply errno status");
+	if (handle->write(data, len, msgs[0]->offset) < 0) {
+		for (unsigned i = 0; i < count; i++) {
+			if (reply_errno_status(msgs[i]) != 0) {
+				Genode::error("process_write(): failed to reply errno status");
+			}
 		}
 		return;
 	}
 
-	if (sftp_reply_status(msg, SSH_FX_OK, nullptr) != 0) {
-		Genode::error("process_write(): failed to reply ok status");
-	}
+	reply_status(SSH_FX_OK, nullptr);
 }
 
 template <typename T, typename DEALLOC>
@@ -999,8 +1300,7 @@ class Destroyer {
 
 void Ssh::Sftp::process_close(sftp_client_message msg)
 {
-	Handle* handle = reinterpret_cast<Handle*>(sftp_handle(_sftp_server,
-	                                                       msg->handle));
+	Handle* handle = lookup_handle(msg->handle);
 	if (handle == nullptr) {
 		Genode::error("process_close(): received invalid handle");
 		if (sftp_reply_status(msg, SSH_FX_INVALID_HANDLE, "invalid handle") != 0) {
@@ -1009,7 +1309,7 @@ void Ssh::Sftp::process_close(sftp_client_message msg)
 		return;
 	}
 
-	sftp_handle_remove(_sftp_server, msg->handle);
+	remove_handle(msg->handle);
 	Destroyer handle_destroyer(&_heap, handle);
 
 	if (handle->_type == Handle::HDIR
@@ -1021,7 +1321,7 @@ void Ssh::Sftp::process_close(sftp_client_message msg)
 	}
 
 	if (handle->_type == Handle::HFILE
-	    && handle->close_file() != 0) {
+	    && handle->close_file(_sync_on_close) != 0) {
 		if (reply_errno_status(msg) != 0) {
 			Genode::error("process_close(): failed to reply errno status");
 		}
@@ -23,6 +23,7 @@
 #include <base/thread.h>
 #include <os/ring_buffer.h>
 #include <session/session.h>
+#include <util/fifo.h>
 
 #define WITH_SERVER
 #include <libssh/sftp.h>
@@ -76,12 +77,80 @@ class Ssh::Sftp
 		static constexpr int CLIENT_REQUESTS_MAX = 128;
 		Ring_buffer<sftp_client_message, CLIENT_REQUESTS_MAX> _client_requests;
 
-		static constexpr int PENDING_PACKETS_MAX = 128;
+		/*
+		 * Each request produces one reply. The dispatcher takes requests
+		 * only while the queued replies and the replies of all queued and
+		 * running jobs fit into the queue, see 'alloc_job'.
+		 */
+		static constexpr int PENDING_PACKETS_MAX = 1024;
 		Ring_buffer<ssh_buffer, PENDING_PACKETS_MAX> _pending_packets;
 
+		/* the ring holds one element less than its size */
+		static constexpr unsigned PENDING_REPLIES_MAX = PENDING_PACKETS_MAX - 1;
+
 		ssh_buffer _output_payload;
 		uint32_t   _output_pos;
 
+		/*
+		 * Reads are answered with up to 'READ_LEN_MAX' bytes, which keeps
+		 * a reply below the maximum SFTP packet size of 256 KiB that
+		 * clients accept. Consecutive queued reads of a handle are
+		 * served by one 'pread' of up to 'READ_BATCH_BYTES'. Likewise,
+		 * consecutive queued writes are written by one 'pwrite'.
+		 */
+		static constexpr uint32_t READ_LEN_MAX     = 255*1024;
+		static constexpr size_t   READ_BATCH_BYTES = 1024*1024;
+		static constexpr unsigned READ_BATCH_MAX   = 64;
+		static constexpr size_t   WRITE_BATCH_BYTES = READ_BATCH_BYTES;
+
+		/* sync written files when they are closed */
+		bool const _sync_on_close;
+
+		/*
+		 * Requests are executed by a pool of workers. Requests on the
+		 * same handle are executed one at a time in order of arrival,
+		 * requests on different handles and requests on paths are
+		 * executed concurrently and their replies may be sent out of
+		 * order, as permitted by the protocol.
+		 */
+		static constexpr unsigned WORKERS  = 4;
+		static constexpr unsigned JOBS_MAX = 2*WORKERS;
+
+		struct Job : Genode::Fifo<Job>::Element
+		{
+			/* single request or batch of consecutive reads or writes */
+			sftp_client_message msgs[READ_BATCH_MAX];
+			unsigned            count   = 0;
+
+			/* handle the requests operate on, nullptr for paths */
+			void const         *key     = nullptr;
+			bool                running = false;
+		};
+
+		Job               _jobs[JOBS_MAX] { };
+		Genode::Fifo<Job> _free_jobs      { };
+		Genode::Fifo<Job> _queued_jobs    { };
+		unsigned          _running_jobs   { 0 };
+		bool              _stopping       { false };
+
+		/* requests of queued and running jobs and replies not yet sent */
+		unsigned          _job_requests   { 0 };
+		unsigned          _queued_replies { 0 };
+
+		/* replies may no longer be sent, requests are not throttled */
+		bool              _closing        { false };
+
+		pthread_mutex_t   _jobs_mutex;
+		pthread_cond_t    _jobs_cond;
+		pthread_t         _workers[WORKERS] { };
+		unsigned          _num_workers    { 0 };
+
+		/* protects the handle table of '_sftp_server' */
+		Genode::Mutex     _handle_table_mutex { };
+
+		/* serializes the workers that enqueue replies */
+		Genode::Mutex     _pending_packets_mutex { };
+
 		static constexpr const char* valid_path_prefix = "/sftp";
 		static constexpr int valid_path_length = 5;
 
@@ -95,9 +164,18 @@ class Ssh::Sftp
 		             CREATE_ERROR,
 		             CLEAN } _state = UNINITIALIZED;
 
-		Sftp(Genode::Heap &heap, Wake_up_signaller &wake_up_signaller)
+		Sftp(Genode::Heap &heap, Wake_up_signaller &wake_up_signaller,
+		     bool sync_on_close)
 			: _heap(heap), _wake_up_signaller(wake_up_signaller),
-			  _output_payload(nullptr), _output_pos(0) {}
+			  _output_payload(nullptr), _output_pos(0),
+			  _sync_on_close(sync_on_close)
+		{
+			pthread_mutex_init(&_jobs_mutex, nullptr);
+			pthread_cond_init(&_jobs_cond, nullptr);
+
+			for (Job &job : _jobs)
+				_free_jobs.enqueue(job);
+		}
 		~Sftp();
 
 		void cleanup();
@@ -128,10 +206,17 @@ class Ssh::Sftp
 			enum Type { HDIR, HFILE } _type;
 			char*                     _name = nullptr;
 			DIR*                      _dir  = nullptr;
-			FILE*                     _file = nullptr;
+			int                       _fd   = -1;
 			bool                      _eof  = false;
 			bool                      _root = false;
 
+			/* file was written since it was opened */
+			bool                      _written = false;
+
+			/* buffer for reads and batched writes, reused across requests */
+			char*                     _buffer      = nullptr;
+			size_t                    _buffer_size = 0;
+
 			Handle(DIR* dir, const char* name, bool root,
 			       Genode::Registry<Handle> &reg)
 				: Element(reg, *this), _type(HDIR), _dir(dir), _root(root)
@@ -139,20 +224,36 @@ class Ssh::Sftp
 				_name = strdup(name);
 			}
 
-			Handle(FILE* file, const char* name, Genode::Registry<Handle> &reg)
-				: Element(reg, *this), _type(HFILE), _file(file)
+			Handle(int fd, const char* name, Genode::Registry<Handle> &reg)
+				: Element(reg, *this), _type(HFILE), _fd(fd)
 			{
 				_name = strdup(name);
 			}
 
 			~Handle() {
 				if (_name != nullptr) ::free(_name);
+				if (_buffer != nullptr) ::free(_buffer);
 				close_dir();
-				close_file();
+				close_file(false);
 			}
 
 			int close_dir();
-			int close_file();
+			int close_file(bool sync);
+
+			/**
+			 * Return read buffer of at least 'size' bytes or nullptr
+			 */
+			char *buffer(size_t size);
+
+			/**
+			 * Read up to 'len' bytes at 'offset', like 'pread'
+			 */
+			ssize_t read(char *dst, size_t len, off_t offset);
+
+			/**
+			 * Write 'len' bytes at 'offset', like 'pwrite'
+			 */
+			ssize_t write(char const *src, size_t len, off_t offset);
 		};
 
 		using Handle_registry = Genode::Registry<Handle>;
@@ -174,15 +275,28 @@ class Ssh::Sftp
 		void process_opendir(sftp_client_message msg);
 		void process_open(sftp_client_message msg);
 		void process_readdir(sftp_client_message msg);
-		void process_read(sftp_client_message msg);
-		void process_write(sftp_client_message msg);
+		bool collect_batch(Job &job, sftp_client_message &next);
+		void process_read(sftp_client_message *msgs, unsigned count);
+		void process_write(sftp_client_message *msgs, unsigned count);
 		void process_close(sftp_client_message msg);
 		void process_stat(sftp_client_message msg, Stat_mode mode);
 		void process_remove(sftp_client_message msg);
 		void process_mkdir(sftp_client_message msg);
 		void process_rmdir(sftp_client_message msg);
 
+		Handle* lookup_handle(ssh_string handle);
+		ssh_string alloc_handle(Handle* handle);
+		void remove_handle(ssh_string handle);
+
+		Job &alloc_job();
+		void queue_job(Job &job);
+		Job *next_runnable_job();
+		void execute_job(Job &job);
+		void start_workers();
+		void stop_workers();
+
 		static void * sftp_worker_loop(void *arg);
+		static void * sftp_job_loop(void *arg);
 };
 
 namespace Genode {
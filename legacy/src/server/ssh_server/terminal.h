@@ -24,6 +24,9 @@
 #include <base/log.h>
 #include <terminal_session/terminal_session.h>
 
+/* libc includes */
+#include <string.h>
+
 /* local includes */
 #include "login.h"
 
@@ -60,6 +63,45 @@ class Ssh::Terminal
 		unsigned _attached_channels { 0u };
 		unsigned _pending_channels  { 0u };
 
+		/**
+		 * Append 'src' to 'buf' with each '\n' expanded to "\r\n"
+		 *
+		 * The text between newlines is copied in chunks, a newline is only
+		 * consumed if there is room for both characters.
+		 *
+		 * \return number of bytes consumed from 'src'
+		 */
+		static size_t _append_expanded(Buffer &buf, char const *src, size_t len)
+		{
+			size_t consumed = 0;
+
+			while (consumed < len) {
+
+				char const  *chunk = src + consumed;
+				size_t const left  = len - consumed;
+				char const  *nl    = (char const *)::memchr(chunk, '\n', left);
+				size_t const text  = nl ? size_t(nl - chunk) : left;
+				size_t const n     = min(text, buf.write_avail());
+
+				buf.append(chunk, n);
+				consumed += n;
+
+				if (n < text || !nl || buf.write_avail() < 2) { break; }
+
+				buf.append('\r');
+				buf.append('\n');
+				consumed++;
+			}
+
+			return consumed;
+		}
+
+		void _wake_up()
+		{
+			char c = 1;
+			::write(write_avail_fd, &c, sizeof(c));
+		}
+
 	public:
 
 		Buffer read_buf { };
@@ -186,15 +228,38 @@ class Ssh::Terminal
 
 			char const *src     = write_buf.content();
 			size_t const len    = write_buf.read_avail();
-			/* XXX we do not handle partial writes */
 			int const num_bytes = ssh_channel_write(channel, src, len);
 
-			if (num_bytes && (size_t)num_bytes < len) {
+			/*
+			 * A write that timed out waiting for the channel window is
+			 * resumed on the next call with the remainder. The progress is
+			 * only tracked for a terminal with a single channel, a
+			 * terminal shared by several channels drops the remainder.
+			 */
+			bool const partial = num_bytes >= 0 && (size_t)num_bytes < len;
+
+			if (partial && _attached_channels == 1) {
+				write_buf.consume(num_bytes);
+				return;
+			}
+
+			if (partial) {
 				warning("send on channel was truncated");
 			}
 
 			if (++_pending_channels >= _attached_channels) {
 				write_buf.reset();
+
+				/*
+				 * Writes into the other buffer did not wake the event loop
+				 * while this one was pending
+				 */
+				bool pending = false;
+				{
+					Mutex::Guard guard(_write_buf_swap);
+					pending = _write_buf_ep->read_avail() > 0;
+				}
+				if (pending) { _wake_up(); }
 			}
 
 			/* at this point the client might have disconnected */
@@ -233,33 +298,24 @@ class Ssh::Terminal
 		size_t write(char const *src, Genode::size_t src_len)
 		{
 			size_t num_bytes = 0;
+			bool   was_empty = false;
 
 			{
 				Mutex::Guard guard(_write_buf_swap);
 
 				Buffer &write_buf = *_write_buf_ep;
 
-				size_t i = 0;
-
-				while (write_buf.write_avail() > 0 && i < src_len) {
-
-					char c = src[i];
-					if (c == '\n') {
-						write_buf.append('\r');
-					}
-
-					write_buf.append(c);
-					num_bytes++;
-
-					i++;
-				}
+				was_empty = !write_buf.read_avail();
+				num_bytes = _append_expanded(write_buf, src, src_len);
 			}
 
-			/* wake the event loop up */
-			Libc::with_libc([&] {
-				char c = 1;
-				::write(write_avail_fd, &c, sizeof(c));
-			});
+			/*
+			 * Wake the event loop up once the buffer becomes non-empty,
+			 * it sends the content of a non-empty buffer on every iteration
+			 */
+			if (was_empty && num_bytes) {
+				Libc::with_libc([&] { _wake_up(); });
+			}
 
 			return num_bytes;
 		}
@@ -87,6 +87,12 @@ struct Util::Buffer
 	char const *content() const { return &_data[_tail]; }
 
 	void append(char c)    { _data[_head++] = c; }
+	void append(char const *src, size_t n)
+	{
+		Genode::memcpy(&_data[_head], src, n);
+		_head += n;
+	}
+
 	void consume(size_t n) { _tail += n; }
 	void reset()           { _head = _tail = 0; }
 
@@ -0,0 +1,112 @@
+/*
+ * \brief  Throughput benchmark of the block_shred noise generator
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <timer_session/connection.h>
+#include <base/attached_ram_dataspace.h>
+#include <base/component.h>
+#include <base/log.h>
+
+/* PCG includes */
+#include <pcg_variants.h>
+
+/* block_shred includes */
+#include <noise.h>
+
+using namespace Genode;
+
+
+struct Main
+{
+	enum { BUFFER_SIZE = 1 << 20, ROUNDS = 256 };
+
+	Env &_env;
+
+	Timer::Connection _timer { _env };
+
+	Attached_ram_dataspace _buffer { _env.ram(), _env.rm(), BUFFER_SIZE };
+
+	template <typename FN>
+	void _measure(char const *name, FN const &fn)
+	{
+		uint64_t const start_us = _timer.elapsed_us();
+		for (unsigned i = 0; i < ROUNDS; ++i)
+			fn(_buffer.local_addr<void>(), i);
+		uint64_t const us = max(_timer.elapsed_us() - start_us, (uint64_t)1);
+
+		uint64_t const bytes = (uint64_t)BUFFER_SIZE*ROUNDS;
+
+		/* bytes per microsecond equals MB per second */
+		log(name, ": ", bytes/us, " MB/s");
+	}
+
+	void _fail(char const *msg)
+	{
+		error(msg);
+		_env.parent().exit(~0);
+	}
+
+	Main(Env &env) : _env(env)
+	{
+		log("--- block_shred noise benchmark started ---");
+
+		Blk_shred::Noise::Seed seed { };
+		for (unsigned i = 0; i < 8; ++i)
+			seed.key[i] = 0x9e3779b9*(i+1);
+		seed.nonce[0] = 1;
+		seed.nonce[1] = 2;
+
+		Blk_shred::Noise noise { seed };
+
+		/* seeking must reproduce the sequential stream */
+		{
+			enum { OFFSET = 3*Blk_shred::Noise::CHUNK_SIZE };
+
+			char *buf = _buffer.local_addr<char>();
+			noise.seek(0);
+			noise.generate(buf, BUFFER_SIZE);
+
+			noise.seek(OFFSET);
+			if (!noise.verify(&buf[OFFSET], BUFFER_SIZE - OFFSET)) {
+				_fail("seeked noise differs from sequential noise");
+				return;
+			}
+
+			buf[BUFFER_SIZE/2] ^= 1;
+			noise.seek(0);
+			if (noise.verify(buf, BUFFER_SIZE)) {
+				_fail("corrupted buffer passed verification");
+				return;
+			}
+		}
+
+		_measure("pcg32", [&] (void *dst, unsigned round) {
+			pcg32_random_t pcg;
+			pcg32_srandom_r(&pcg, round, 1);
+			uint32_t *words = (uint32_t *)dst;
+			for (size_t i = 0; i < BUFFER_SIZE/sizeof(uint32_t); ++i)
+				words[i] = pcg32_random_r(&pcg);
+		});
+
+		_measure("chacha8", [&] (void *dst, unsigned round) {
+			noise.seek((uint64_t)round*BUFFER_SIZE);
+			noise.generate(dst, BUFFER_SIZE);
+		});
+
+		log("--- block_shred noise benchmark finished ---");
+		_env.parent().exit(0);
+	}
+};
+
+
+void Component::construct(Env &env) { static Main main(env); }
@@ -0,0 +1,6 @@
+TARGET  = test-block_shred_noise
+SRC_CC  = main.cc
+LIBS    = base libpcg_random
+INC_DIR = $(call select_from_repositories,src/app/block_shred)
+
+CC_CXX_WARN_STRICT_CONVERSION =
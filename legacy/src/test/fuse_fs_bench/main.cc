@@ -0,0 +1,464 @@
+/*
+ * \brief  File-system benchmark for fuse_fs
+ * \author Genode Labs
+ * \date   2026-10-19
+ *
+ * The workloads are run in order:
+ *
+ * - sequential write and read of a file in chunks of 1 MiB
+ * - random writes and reads of 4 KiB within that file
+ * - creation, status, and removal of small files
+ * - a directory listing that fills a directory in steps that double
+ *   the number of entries and lists it after each step. With a linear
+ *   listing cost, the time per entry stays constant across steps.
+ * - appending small records to a file like a logger does
+ * - following such a log through a second file handle like 'tail' does,
+ *   which checks that each record is read back as written and that a
+ *   truncation by another handle is not undone by buffered content
+ *
+ * Each result is printed as one line that starts with '[result]'
+ * followed by 'key=value' pairs, which are collected by the run script.
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* libc includes */
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+
+static char const *backend = "unknown";
+
+
+static unsigned long long now_us()
+{
+	struct timespec ts { };
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec*1000000ULL + ts.tv_nsec/1000;
+}
+
+
+static unsigned long long per_sec(unsigned long long count, unsigned long long usec) {
+	return usec ? count*1000000ULL/usec : 0; }
+
+
+enum { CHUNK = 1024*1024, RANDOM_BLOCK = 4096 };
+
+
+static int bench_sequential(char const *base, unsigned size_mb)
+{
+	char path[256];
+	snprintf(path, sizeof(path), "%s/sequential.dat", base);
+
+	char *chunk = (char *)malloc(CHUNK);
+	if (!chunk)
+		return -1;
+	for (unsigned i = 0; i < CHUNK; ++i)
+		chunk[i] = (char)i;
+
+	unsigned long long const bytes = (unsigned long long)size_mb*CHUNK;
+
+	int fd = open(path, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+	if (fd < 0) {
+		fprintf(stderr, "open '%s' failed: %s\n", path, strerror(errno));
+		free(chunk);
+		return -1;
+	}
+
+	unsigned long long start = now_us();
+	for (unsigned i = 0; i < size_mb; ++i) {
+		if (write(fd, chunk, CHUNK) != CHUNK) {
+			fprintf(stderr, "write to '%s' failed: %s\n", path, strerror(errno));
+			close(fd);
+			free(chunk);
+			return -1;
+		}
+	}
+	fsync(fd);
+	unsigned long long usec = now_us() - start;
+	close(fd);
+
+	printf("[result] backend=%s workload=seq_write block_size=%u bytes=%llu usec=%llu kib_per_sec=%llu\n",
+	       backend, CHUNK, bytes, usec, per_sec(bytes/1024, usec));
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "open '%s' failed: %s\n", path, strerror(errno));
+		free(chunk);
+		return -1;
+	}
+
+	start = now_us();
+	for (unsigned i = 0; i < size_mb; ++i) {
+		if (read(fd, chunk, CHUNK) != CHUNK) {
+			fprintf(stderr, "read from '%s' failed: %s\n", path, strerror(errno));
+			close(fd);
+			free(chunk);
+			return -1;
+		}
+	}
+	usec = now_us() - start;
+	close(fd);
+	free(chunk);
+
+	printf("[result] backend=%s workload=seq_read block_size=%u bytes=%llu usec=%llu kib_per_sec=%llu\n",
+	       backend, CHUNK, bytes, usec, per_sec(bytes/1024, usec));
+	return 0;
+}
+
+
+/**
+ * Random 4 KiB writes and reads within the file of the sequential workload
+ */
+static int bench_random(char const *base, unsigned size_mb, unsigned ops)
+{
+	char path[256];
+	snprintf(path, sizeof(path), "%s/sequential.dat", base);
+
+	unsigned const blocks = size_mb*(CHUNK/RANDOM_BLOCK);
+
+	int fd = open(path, O_RDWR);
+	if (fd < 0) {
+		fprintf(stderr, "open '%s' failed: %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	char block[RANDOM_BLOCK];
+	memset(block, 'r', sizeof(block));
+
+	/* same sequence of offsets on each backend */
+	unsigned seed = 1;
+	auto next_offset = [&] () {
+		seed = seed*1103515245U + 12345U;
+		return (off_t)((seed >> 8) % blocks)*RANDOM_BLOCK; };
+
+	unsigned long long start = now_us();
+	for (unsigned i = 0; i < ops; ++i) {
+		if (pwrite(fd, block, sizeof(block), next_offset()) != (ssize_t)sizeof(block)) {
+			fprintf(stderr, "pwrite to '%s' failed: %s\n", path, strerror(errno));
+			close(fd);
+			return -1;
+		}
+	}
+	fsync(fd);
+	unsigned long long usec = now_us() - start;
+
+	printf("[result] backend=%s workload=rand_write block_size=%u ops=%u usec=%llu iops=%llu\n",
+	       backend, RANDOM_BLOCK, ops, usec, per_sec(ops, usec));
+
+	seed  = 2;
+	start = now_us();
+	for (unsigned i = 0; i < ops; ++i) {
+		if (pread(fd, block, sizeof(block), next_offset()) != (ssize_t)sizeof(block)) {
+			fprintf(stderr, "pread from '%s' failed: %s\n", path, strerror(errno));
+			close(fd);
+			return -1;
+		}
+	}
+	usec = now_us() - start;
+	close(fd);
+
+	printf("[result] backend=%s workload=rand_read block_size=%u ops=%u usec=%llu iops=%llu\n",
+	       backend, RANDOM_BLOCK, ops, usec, per_sec(ops, usec));
+
+	unlink(path);
+	return 0;
+}
+
+
+static int bench_small_files(char const *base, unsigned files)
+{
+	char dir[256];
+	snprintf(dir, sizeof(dir), "%s/small", base);
+	if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+		fprintf(stderr, "mkdir '%s' failed: %s\n", dir, strerror(errno));
+		return -1;
+	}
+
+	char content[1024];
+	memset(content, 's', sizeof(content));
+
+	char path[256];
+
+	unsigned long long start = now_us();
+	for (unsigned i = 0; i < files; ++i) {
+		snprintf(path, sizeof(path), "%s/file-%06u", dir, i);
+		int fd = open(path, O_CREAT | O_WRONLY, 0644);
+		if (fd < 0 || write(fd, content, sizeof(content)) != (ssize_t)sizeof(content)) {
+			fprintf(stderr, "create '%s' failed: %s\n", path, strerror(errno));
+			if (fd >= 0)
+				close(fd);
+			return -1;
+		}
+		close(fd);
+	}
+	unsigned long long usec = now_us() - start;
+
+	printf("[result] backend=%s workload=create files=%u file_size=%zu usec=%llu ops_per_sec=%llu\n",
+	       backend, files, sizeof(content), usec, per_sec(files, usec));
+
+	start = now_us();
+	for (unsigned i = 0; i < files; ++i) {
+		snprintf(path, sizeof(path), "%s/file-%06u", dir, i);
+		struct stat st { };
+		if (stat(path, &st) != 0 || st.st_size != (off_t)sizeof(content)) {
+			fprintf(stderr, "stat '%s' failed\n", path);
+			return -1;
+		}
+	}
+	usec = now_us() - start;
+
+	printf("[result] backend=%s workload=stat files=%u usec=%llu ops_per_sec=%llu\n",
+	       backend, files, usec, per_sec(files, usec));
+
+	start = now_us();
+	for (unsigned i = 0; i < files; ++i) {
+		snprintf(path, sizeof(path), "%s/file-%06u", dir, i);
+		if (unlink(path) != 0) {
+			fprintf(stderr, "unlink '%s' failed: %s\n", path, strerror(errno));
+			return -1;
+		}
+	}
+	usec = now_us() - start;
+
+	printf("[result] backend=%s workload=unlink files=%u usec=%llu ops_per_sec=%llu\n",
+	       backend, files, usec, per_sec(files, usec));
+	return 0;
+}
+
+
+static bool create_entries(char const *dir, unsigned from, unsigned to)
+{
+	char path[256];
+	for (unsigned i = from; i < to; ++i) {
+		snprintf(path, sizeof(path), "%s/entry-%06u", dir, i);
+		int fd = open(path, O_CREAT | O_WRONLY, 0644);
+		if (fd < 0) {
+			fprintf(stderr, "create '%s' failed: %s\n", path, strerror(errno));
+			return false;
+		}
+		close(fd);
+	}
+	return true;
+}
+
+
+/**
+ * List a directory
+ *
+ * \return number of entries or -1 on error
+ */
+static long list_dir(char const *dir)
+{
+	DIR *d = opendir(dir);
+	if (!d)
+		return -1;
+
+	long count = 0;
+	while (readdir(d))
+		++count;
+
+	closedir(d);
+	return count;
+}
+
+
+static int bench_list(char const *base, unsigned max_entries, unsigned rounds)
+{
+	char dir[256];
+	snprintf(dir, sizeof(dir), "%s/list", base);
+	if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+		fprintf(stderr, "mkdir '%s' failed: %s\n", dir, strerror(errno));
+		return -1;
+	}
+
+	unsigned entries = 0;
+	for (unsigned step = max_entries/8 ? max_entries/8 : max_entries;
+	     entries < max_entries; step = entries) {
+
+		unsigned const target = entries + step > max_entries
+		                      ? max_entries : entries + step;
+
+		if (!create_entries(dir, entries, target))
+			return -1;
+		entries = target;
+
+		unsigned long long const start = now_us();
+		long count = 0;
+		for (unsigned r = 0; r < rounds; ++r)
+			count = list_dir(dir);
+		unsigned long long const usec = (now_us() - start) / rounds;
+
+		if (count < (long)entries) {
+			fprintf(stderr, "listing '%s' returned %ld of %u entries\n",
+			        dir, count, entries);
+			return -1;
+		}
+
+		printf("[result] backend=%s workload=list entries=%u usec=%llu nsec_per_entry=%llu\n",
+		       backend, entries, usec, usec*1000/entries);
+	}
+	return 0;
+}
+
+
+static int bench_append(char const *base, unsigned records)
+{
+	char path[256];
+	snprintf(path, sizeof(path), "%s/append.log", base);
+
+	int fd = open(path, O_CREAT | O_TRUNC | O_WRONLY | O_APPEND, 0644);
+	if (fd < 0) {
+		fprintf(stderr, "open '%s' failed: %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	char record[128];
+	memset(record, 'x', sizeof(record));
+	record[sizeof(record) - 1] = '\n';
+
+	unsigned long long const start = now_us();
+	for (unsigned i = 0; i < records; ++i) {
+		if (write(fd, record, sizeof(record)) != (ssize_t)sizeof(record)) {
+			fprintf(stderr, "append to '%s' failed: %s\n", path, strerror(errno));
+			close(fd);
+			return -1;
+		}
+	}
+	unsigned long long const usec = now_us() - start;
+	close(fd);
+
+	struct stat st { };
+	if (stat(path, &st) != 0 || st.st_size != (off_t)records*(off_t)sizeof(record)) {
+		fprintf(stderr, "unexpected size of '%s'\n", path);
+		return -1;
+	}
+
+	printf("[result] backend=%s workload=append records=%u record_size=%zu usec=%llu ops_per_sec=%llu\n",
+	       backend, records, sizeof(record), usec, per_sec(records, usec));
+	return 0;
+}
+
+
+static int bench_tail(char const *base, unsigned records)
+{
+	char path[256];
+	snprintf(path, sizeof(path), "%s/tail.log", base);
+
+	int const wfd = open(path, O_CREAT | O_TRUNC | O_WRONLY | O_APPEND, 0644);
+	int const rfd = open(path, O_RDONLY);
+	if (wfd < 0 || rfd < 0) {
+		fprintf(stderr, "open '%s' failed: %s\n", path, strerror(errno));
+		if (wfd >= 0) close(wfd);
+		if (rfd >= 0) close(rfd);
+		return -1;
+	}
+
+	char record[128], tail[128];
+	int result = 0;
+
+	unsigned long long const start = now_us();
+	for (unsigned i = 0; i < records && result == 0; ++i) {
+		memset(record, 'a' + i % 26, sizeof(record));
+		record[sizeof(record) - 1] = '\n';
+
+		if (write(wfd, record, sizeof(record)) != (ssize_t)sizeof(record)) {
+			fprintf(stderr, "append to '%s' failed: %s\n", path, strerror(errno));
+			result = -1;
+		} else
+		if (read(rfd, tail, sizeof(tail)) != (ssize_t)sizeof(tail)
+		 || memcmp(record, tail, sizeof(record)) != 0) {
+			fprintf(stderr, "record %u of '%s' not read back\n", i, path);
+			result = -1;
+		}
+	}
+	unsigned long long const usec = now_us() - start;
+	close(rfd);
+
+	/* the record buffered for 'wfd' must not reappear after the truncation */
+	if (result == 0) {
+		int tfd = -1;
+		if (write(wfd, record, sizeof(record)) == (ssize_t)sizeof(record))
+			tfd = open(path, O_WRONLY | O_TRUNC);
+		if (tfd >= 0)
+			close(tfd);
+		close(wfd);
+
+		struct stat st { };
+		if (tfd < 0 || stat(path, &st) != 0 || st.st_size != 0) {
+			fprintf(stderr, "truncation of '%s' undone\n", path);
+			result = -1;
+		}
+	} else {
+		close(wfd);
+	}
+
+	if (result != 0)
+		return result;
+
+	printf("[result] backend=%s workload=tail records=%u record_size=%zu usec=%llu ops_per_sec=%llu\n",
+	       backend, records, sizeof(record), usec, per_sec(records, usec));
+	return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+	char const *base        = "/fs";
+	unsigned    max_entries = 10000;
+	unsigned    rounds      = 3;
+	unsigned    size_mb     = 32;
+	unsigned    random_ops  = 4096;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "b:d:n:r:s:i:")) != -1) {
+		switch (opt) {
+		case 'b': backend     = optarg;               break;
+		case 'd': base        = optarg;               break;
+		case 'n': max_entries = strtoul(optarg, 0, 0); break;
+		case 'r': rounds      = strtoul(optarg, 0, 0); break;
+		case 's': size_mb     = strtoul(optarg, 0, 0); break;
+		case 'i': random_ops  = strtoul(optarg, 0, 0); break;
+		default:
+			fprintf(stderr, "usage: %s [-b backend] [-d dir] [-n entries] "
+			                "[-r rounds] [-s size_mb] [-i random_ops]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (!max_entries || !rounds || !size_mb || !random_ops)
+		return 1;
+
+	if (bench_sequential(base, size_mb) != 0)
+		return 1;
+
+	if (bench_random(base, size_mb, random_ops) != 0)
+		return 1;
+
+	if (bench_small_files(base, max_entries) != 0)
+		return 1;
+
+	if (bench_list(base, max_entries, rounds) != 0)
+		return 1;
+
+	if (bench_append(base, max_entries) != 0)
+		return 1;
+
+	if (bench_tail(base, max_entries) != 0)
+		return 1;
+
+	printf("benchmark completed\n");
+	return 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * \brief  Test and benchmark of the SPSC magic ring buffer
+ * \author Genode Labs
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <world/spsc_magic_ring_buffer.h>
+#include <timer_session/connection.h>
+#include <base/component.h>
+#include <base/thread.h>
+#include <base/log.h>
+
+using namespace Genode;
+
+typedef Spsc_magic_ring_buffer<uint32_t> Ring;
+
+
+/**
+ * Producer of a sequence of numbers on a separate thread
+ */
+struct Producer : Thread
+{
+	Ring &_ring;
+
+	uint32_t const _count;
+
+	/* number of items written per operation */
+	size_t const _chunk;
+
+	Producer(Env &env, Ring &ring, uint32_t count, size_t chunk)
+	:
+		Thread(env, "producer", 16UL * 1024 * sizeof(long)),
+		_ring(ring), _count(count), _chunk(chunk)
+	{ }
+
+	void entry() override
+	{
+		uint32_t next = 0;
+		while (next < _count) {
+			size_t const n = min(_ring.write_avail(), min(_chunk, size_t(_count - next)));
+			if (!n) continue;
+
+			uint32_t *dst = _ring.write_addr();
+			for (size_t i = 0; i < n; ++i)
+				dst[i] = next++;
+			_ring.fill(n);
+		}
+	}
+};
+
+
+struct Main
+{
+	enum { RING_SIZE = 1 << 16 };
+
+	Env &_env;
+
+	Timer::Connection _timer { _env };
+
+	void _check(bool condition, char const *msg)
+	{
+		if (condition) return;
+
+		error(msg);
+		_env.parent().exit(~0);
+		sleep_forever();
+	}
+
+	void _test_single_thread()
+	{
+		Ring ring { _env, 5000 };
+
+		_check(ring.capacity() == 8192/sizeof(uint32_t),
+		       "capacity not rounded to a power of two");
+		_check(ring.write_avail() == ring.capacity(),
+		       "empty ring does not offer its whole capacity");
+		_check(ring.read_avail() == 0, "empty ring is readable");
+
+		/* move the positions close to the end of the buffer */
+		size_t const offset = ring.capacity() - 3;
+		ring.fill(offset);
+		ring.drain(offset);
+
+		/* a write across the end is contiguous */
+		uint32_t *dst = ring.write_addr();
+		for (uint32_t i = 0; i < 16; ++i)
+			dst[i] = i;
+		ring.fill(16);
+
+		_check(ring.read_avail() == 16, "read_avail does not match fill");
+		_check(ring.write_avail() == ring.capacity() - 16,
+		       "write_avail does not match fill");
+
+		uint32_t const *src = ring.read_addr();
+		for (uint32_t i = 0; i < 16; ++i)
+			_check(src[i] == i, "wrapped items differ");
+		ring.drain(16);
+
+		/* every item of the ring is usable */
+		ring.fill(ring.capacity());
+		_check(ring.write_avail() == 0, "full ring is writeable");
+		_check(ring.read_avail() == ring.capacity(), "full ring not readable");
+		ring.drain(ring.capacity());
+
+		log("single-thread test passed");
+	}
+
+	void _test_cross_thread(uint32_t count, size_t chunk)
+	{
+		Ring ring { _env, RING_SIZE };
+
+		Producer producer { _env, ring, count, chunk };
+
+		uint64_t const start_us = _timer.elapsed_us();
+		producer.start();
+
+		uint32_t expected = 0;
+		while (expected < count) {
+			size_t const n = ring.read_avail();
+			if (!n) continue;
+
+			uint32_t const *src = ring.read_addr();
+			for (size_t i = 0; i < n; ++i)
+				_check(src[i] == expected++, "consumer read unexpected item");
+			ring.drain(n);
+		}
+
+		uint64_t const us = max(_timer.elapsed_us() - start_us, (uint64_t)1);
+		producer.join();
+
+		/* bytes per microsecond equals MB per second */
+		log("cross-thread test passed, chunk ", chunk, ": ",
+		    (uint64_t(count)*sizeof(uint32_t))/us, " MB/s");
+	}
+
+	Main(Env &env) : _env(env)
+	{
+		log("--- SPSC magic ring buffer test started ---");
+
+		_test_single_thread();
+		_test_cross_thread(1 << 24, 64);
+		_test_cross_thread(1 << 24, 4096);
+
+		log("--- SPSC magic ring buffer test finished ---");
+		_env.parent().exit(0);
+	}
+};
+
+
+void Component::construct(Env &env) { static Main main(env); }
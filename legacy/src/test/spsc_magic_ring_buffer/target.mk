@@ -0,0 +1,3 @@
+TARGET = test-spsc_magic_ring_buffer
+SRC_CC = main.cc
+LIBS   = base